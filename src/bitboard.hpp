@@ -24,9 +24,9 @@
  */
 #pragma region 
 #include <iostream>
-#include <intrin.h>
 #include <sstream>
 #include <bitset>
+#include "intrinsics.hpp"
 #include "bitutils.hpp"
 #pragma endregion
 
@@ -36,60 +36,38 @@
 using namespace std;
 
 /**
- * MARKER Microsoft C++ Bitscan utils
+ * MARKER Bitboard class template (Used to handle bitwise operations in board of 8x8 and 16x16)
+ * 
+ * Size is a compile-time property: Bitboard<64> (8x8) and Bitboard<256> (16x16)
  */
-#pragma region 
-#pragma intrinsic(_BitScanReverse64)
-#pragma intrinsic(_BitScanForward64)
-#pragma endregion
+template <int N>
+class Bitboard;
+
+template <int N>
+class BitboardIterator;
 
 /**
- * MARKER Base bitboard class (Used to handle bitwise operations in board of 8x8 and 16x16)
+ * MARKER 8x8 bitboard (Plain 8 byte value)
  */
-class Bitboard
+template <>
+class Bitboard<64>
 {
 public:
-    U64 main; //Used for 8x8 board / 4 first rows (16x16 board)
-    U64 b;    //Rows 5-8 (16x16 board)
-    U64 c;    //Rows 9-12 (16x16 board)
-    U64 d;    //Rows 13-16 (16x16 board)
+    U64 main; //Used for 8x8 board
 
-public:
-    bool is16_16;
-    int squares;
-    int size;
+    static const int squares = 64;
+    static const int size = 8;
 
     /**
      * MARKER Constructors
      */
     #pragma region 
-    Bitboard() //NULL Bitboard (Used only by arrays)
-    {
-    }
-
-    /**
-     * MARKER 8X8 Bitboard constructor
-     */
-    Bitboard(U64 a)
+    constexpr Bitboard() : main(0) //Empty bitboard
     {
-        this->is16_16 = false;
-        this->main = a;
-        size = 64;
-        size = 8;
     }
 
-    /**
-     * MARKER 16X16 Bitboard constructor
-     */
-    Bitboard(U64 d, U64 c, U64 b, U64 a)
+    constexpr Bitboard(U64 a) : main(a)
     {
-        this->is16_16 = true;
-        this->main = a;
-        this->b = b;
-        this->c = c;
-        this->d = d;
-        size = 256;
-        size = 16;
     }
     #pragma endregion
 
@@ -97,177 +75,48 @@ public:
      * MARKER Bit Get And Set
      */
     #pragma region 
-    bool get(U8 x, U8 y)
+    bool get(U8 x, U8 y) const
     {
-        if (is16_16)
-        {
-            U8 s = y * 16 + x;
-
-            if (s < 64)
-                return (d & (1ULL << s)) >> s;
-            else if (s < 128)
-                return (c & (1ULL << s)) >> s;
-            else if (s < 192)
-                return (b & (1ULL << s)) >> s;
-            else
-                return (main & (1ULL << s)) >> s;
-        }
-        else
-        {
-            U8 s = y * 8 + x;
-            return (main & (1 << s)) >> s;
-        }
+        return get(y * 8 + x);
     }
     
-    bool get(U8 s)
+    bool get(U8 s) const
     {
-        if (is16_16)
-        {
-            if (s < 64)
-                return (d & (1ULL << s)) >> s;
-            else if (s < 128)
-                return (c & (1ULL << s)) >> s;
-            else if (s < 192)
-                return (b & (1ULL << s)) >> s;
-            else
-                return (main & (1ULL << s)) >> s;
-        }
-        else
-        {
-            return (main & (1 << s)) >> s;
-        }
+        return (main >> s) & 1;
     }
 
     void set(U8 x, U8 y, bool value)
     {
-        if (is16_16)
-        {
-            U8 s = y * 16 + x;
-
-            if (value)
-            {
-                if (s < 64)
-                    d |= u64a1 << (s % 64);
-                else if (s < 128)
-                    c |= u64a1 << (s % 64);
-                else if (s < 192)
-                    b |= u64a1 << (s % 64);
-                else
-                    main |= u64a1 << (s % 64);
-            }
-            else
-            {
-                if (s < 64)
-                    d &= ~(u64a1 << (s % 64));
-                else if (s < 128)
-                    c &= ~(u64a1 << (s % 64));
-                else if (s < 192)
-                    b &= ~(u64a1 << (s % 64));
-                else
-                    main &= ~(u64a1 << (s % 64));
-            }
-        }
-        else
-        {
-            U8 s = y * 8 + x;
-
-            if (value)
-                main |= u64a1 << s;
-            else
-                main &= ~(u64a1 << s);
-        }
+        set(y * 8 + x, value);
     }
 
     void set(U8 s, bool value)
     {
-        if (is16_16)
-        {
-            if (value)
-            {
-                if (s < 64)
-                    d |= u64a1 << (s % 64);
-                else if (s < 128)
-                    c |= u64a1 << (s % 64);
-                else if (s < 192)
-                    b |= u64a1 << (s % 64);
-                else
-                    main |= u64a1 << (s % 64);
-            }
-            else
-            {
-                if (s < 64)
-                    d &= ~(u64a1 << (s % 64));
-                else if (s < 128)
-                    c &= ~(u64a1 << (s % 64));
-                else if (s < 192)
-                    b &= ~(u64a1 << (s % 64));
-                else
-                    main &= ~(u64a1 << (s % 64));
-            }
-        }
+        if (value)
+            main |= u64a1 << s;
         else
-        {
-            if (value)
-                main |= u64a1 << s;
-            else
-                main &= ~(u64a1 << s);
-        }
+            main &= ~(u64a1 << s);
     }
     #pragma endregion
 
     /**
-     * MARKER Print bitboard in 8x8 or 16x16 bits format
+     * MARKER Print bitboard in 8x8 bits format
      */
-    void print()
+    void print() const
     {
-        if (is16_16)
+        printf("\n");
+        bitset<64> b(main);
+        string tmp = b.to_string();
+        int count = 0;
+        for (int i = 0; i < 8; i++)
         {
-            unsigned long long arr[4] = {main, b, c, d};
-
             printf("\n");
-            for (int i = 0; i < 4; i++)
+            for (int j = 0; j < 8; j++)
             {
-                stringstream ss;
-                ss << arr[i];
-
-                U64 x;
-                ss >> x;
-                bitset<64> b(x);
-                string tmp = b.to_string();
-                int count = 0;
-                for (int i = 0; i < 4; i++)
-                {
-                    printf("\n");
-                    for (int j = 0; j < 16; j++)
-                    {
-                        printf("%c ", tmp[count + (15 - j)]);
-                    }
-
-                    count += 16;
-                }
+                printf("%c ", tmp[count + (7 - j)]);
             }
-        }
-        else
-        {
-            printf("\n");
-            stringstream ss;
-            ss << main;
 
-            U64 x;
-            ss >> x;
-            bitset<64> b(x);
-            string tmp = b.to_string();
-            int count = 0;
-            for (int i = 0; i < 8; i++)
-            {
-                printf("\n");
-                for (int j = 0; j < 8; j++)
-                {
-                    printf("%c ", tmp[count + (7 - j)]);
-                }
-
-                count += 8;
-            }
+            count += 8;
         }
     }
 
@@ -277,475 +126,585 @@ public:
     void clear()
     {
         main = 0;
-
-        if(is16_16)
-        {
-            b = 0;
-            c = 0;
-            d = 0;    
-        }
     }
+
     /**
      * MARKER Bitwise utils
      */
     #pragma region 
     //Count all 1 of board
-    U8 popCount()
+    U8 popCount() const
     {
-        if (this->is16_16)
-        {
-            return __popcnt64(main) + __popcnt64(b) + __popcnt64(c) + __popcnt64(d);
-        }
-        else
-            return __popcnt64(main);
+        return _bitcount64(main);
     }
 
-    //Scan previous and pop
+    //Scan next and pop (Lowest bit is reset with x & (x - 1))
     int bitScanPopNext()
     {
-        unsigned long pos = 0;
+        if (!main)
+            return -1;
 
-        if (this->is16_16)
-        {
-            if (_BitScanReverse64(&pos, d))
-            {
-                d &= ~(u64a1 << pos);
-                return pos;
-            }
+        int pos = _lsb64(main);
+        main = _resetlsb64(main);
+        return pos;
+    }
 
-            if (_BitScanReverse64(&pos, c))
-            {
-                c &= ~(u64a1 << pos);
-                return pos + 64;
-            }
+    //Scan previous
+    int bitScanReverse() const
+    {
+        return main ? _msb64(main) : -1;
+    }
+    
+    //Scan forward
+    int bitScanForward() const
+    {
+        return main ? _lsb64(main) : -1;
+    }
+    #pragma endregion
 
-            if (_BitScanReverse64(&pos, b))
-            {
-                b &= ~(u64a1 << pos);
-                return pos + 128;
-            }
+    /**
+     * MARKER Set bit iterator
+     * 
+     * for (int square : bitboard) visits every set square (Lowest first) of a copy
+     */
+    #pragma region 
+    BitboardIterator<64> begin() const;
+    BitboardIterator<64> end() const;
+    #pragma endregion
 
-            if (_BitScanReverse64(&pos, main))
-            {
-                main &= ~(u64a1 << pos);
-                return pos + 192;
-            }
-        }
-        else
-        {
-            _BitScanReverse64(&pos, main);
-            {
-                main &= ~(u64a1 << pos);
-                return pos;
-            }
-        }
+    /**
+     * MARKER Return true if at least one bit is set as true (popCount() > 0)
+     */
+    constexpr bool has() const
+    {
+        return main != 0;
+    }
 
-        return -1;
+    /**
+     * MARKER Operators
+     */
+    #pragma region 
+    //Bitwise & (AND) 
+    constexpr Bitboard operator&(const Bitboard &board) const
+    {
+        return Bitboard(main & board.main);
     }
 
-    //Scan previous
-    int bitScanReverse()
+    //Bitwise | (OR)
+    constexpr Bitboard operator|(const Bitboard &board) const
     {
-        unsigned long pos = 0;
+        return Bitboard(main | board.main);
+    }
 
-        if (this->is16_16)
-        {
-            if (_BitScanReverse64(&pos, d))
-                return pos;
+    //Bitwise ^ (XOR)
+    constexpr Bitboard operator^(const Bitboard &board) const
+    {
+        return Bitboard(main ^ board.main);
+    }
 
-            if (_BitScanReverse64(&pos, c))
-                return pos + 64;
+    //Bitwise & ~ (AND NOT)
+    constexpr Bitboard andNot(const Bitboard &board) const
+    {
+        return Bitboard(main & ~board.main);
+    }
 
-            if (_BitScanReverse64(&pos, b))
-                return pos + 128;
+    //Bitwise Complement/Inverse
+    constexpr Bitboard operator~() const
+    {
+        return Bitboard(~main);
+    }
 
-            if (_BitScanReverse64(&pos, main))
-                return pos + 192;
-        }
-        else
-        {
-            if (_BitScanReverse64(&pos, main))
-                return pos;
-        }
+    //Bitwise << (Right Shift)
+    constexpr Bitboard operator<<(int move) const
+    {
+        return Bitboard(main << move);
+    }
 
-        return -1;
+    //Bitwise >> (Left Shift)
+    constexpr Bitboard operator>>(int move) const
+    {
+        return Bitboard(main >> move);
     }
-    
-    //Scan forward and pop
-    int bitScanForward()
+
+    //Bitwise | (OR)
+    Bitboard &operator|=(const Bitboard &board)
     {
-        unsigned long pos = 0;
+        main |= board.main;
+        return *this;
+    }
 
-        if (this->is16_16)
-        {
-            if (_BitScanForward64(&pos, d))
-                return pos;
+    //Bitwise && (AND)
+    Bitboard &operator&=(const Bitboard &board)
+    {
+        main &= board.main;
+        return *this;
+    }
 
-            if (_BitScanForward64(&pos, c))
-                return pos + 64;
+    //Bitwise ^ (XOR)
+    Bitboard &operator^=(const Bitboard &board)
+    {
+        main ^= board.main;
+        return *this;
+    }
+    #pragma endregion
+};
 
-            if (_BitScanForward64(&pos, b))
-                return pos + 128;
+/**
+ * MARKER 16x16 bitboard (256 bits)
+ * 
+ * Square s lives at bit s % 64 of limbs[s / 64]. With AVX2 every operation runs on a single
+ * __m256i register, otherwise on the four limbs. Shifts carry between limbs (Rows 4/5, 8/9 and 12/13)
+ */
+template <>
+class Bitboard<256>
+{
+public:
+    alignas(32) U64 limbs[4]; //Rows 1-4, 5-8, 9-12 and 13-16
 
-            if (_BitScanForward64(&pos, main))
-                return pos + 192;
-        }
+    static const int squares = 256;
+    static const int size = 16;
+
+    /**
+     * MARKER Constructors
+     */
+    #pragma region 
+    constexpr Bitboard() : limbs{0, 0, 0, 0} //Empty bitboard
+    {
+    }
+
+    constexpr Bitboard(U64 a, U64 b, U64 c, U64 d) : limbs{a, b, c, d}
+    {
+    }
+
+#if defined(__AVX2__)
+    Bitboard(__m256i v)
+    {
+        _mm256_store_si256((__m256i *)limbs, v);
+    }
+
+    inline __m256i vector() const
+    {
+        return _mm256_load_si256((const __m256i *)limbs);
+    }
+#endif
+    #pragma endregion
+
+    /**
+     * MARKER Bit Get And Set
+     */
+    #pragma region 
+    bool get(U8 x, U8 y) const
+    {
+        return get(y * 16 + x);
+    }
+    
+    bool get(U8 s) const
+    {
+        return (limbs[s / 64] >> (s % 64)) & 1;
+    }
+
+    void set(U8 x, U8 y, bool value)
+    {
+        set(y * 16 + x, value);
+    }
+
+    void set(U8 s, bool value)
+    {
+        if (value)
+            limbs[s / 64] |= u64a1 << (s % 64);
         else
+            limbs[s / 64] &= ~(u64a1 << (s % 64));
+    }
+    #pragma endregion
+
+    /**
+     * MARKER Print bitboard in 16x16 bits format
+     */
+    void print() const
+    {
+        printf("\n");
+        for (int i = 3; i >= 0; i--)
         {
-            if (_BitScanForward64(&pos, main))
-                return pos;
+            bitset<64> b(limbs[i]);
+            string tmp = b.to_string();
+            int count = 0;
+            for (int i = 0; i < 4; i++)
+            {
+                printf("\n");
+                for (int j = 0; j < 16; j++)
+                {
+                    printf("%c ", tmp[count + (15 - j)]);
+                }
+
+                count += 16;
+            }
         }
+    }
 
-        return -1;
+    /**
+     * MARKER Clear bitboard data
+     */
+    void clear()
+    {
+        limbs[0] = limbs[1] = limbs[2] = limbs[3] = 0;
+    }
+
+    /**
+     * MARKER Bitwise utils
+     */
+    #pragma region 
+    //Count all 1 of board
+    int popCount() const
+    {
+        return _bitcount64(limbs[0]) + _bitcount64(limbs[1]) + _bitcount64(limbs[2]) + _bitcount64(limbs[3]);
+    }
+
+    //Mask of the non empty limbs (Bit i set if limbs[i] != 0)
+    inline int nonEmptyLimbs() const
+    {
+#if defined(__AVX2__)
+        __m256i zero = _mm256_cmpeq_epi64(vector(), _mm256_setzero_si256());
+        return ~_mm256_movemask_pd(_mm256_castsi256_pd(zero)) & 15;
+#else
+        return (limbs[0] != 0) | ((limbs[1] != 0) << 1) | ((limbs[2] != 0) << 2) | ((limbs[3] != 0) << 3);
+#endif
+    }
+
+    //Scan next and pop (Lowest bit is reset with x & (x - 1))
+    int bitScanPopNext()
+    {
+        int mask = nonEmptyLimbs();
+
+        if (!mask)
+            return -1;
+
+        int limb = _lsb64(mask);
+        int pos = _lsb64(limbs[limb]);
+        limbs[limb] = _resetlsb64(limbs[limb]);
+        return pos + limb * 64;
+    }
+
+    //Scan previous
+    int bitScanReverse() const
+    {
+        int mask = nonEmptyLimbs();
+
+        if (!mask)
+            return -1;
+
+        int limb = _msb64(mask);
+        return _msb64(limbs[limb]) + limb * 64;
+    }
+    
+    //Scan forward
+    int bitScanForward() const
+    {
+        int mask = nonEmptyLimbs();
+
+        if (!mask)
+            return -1;
+
+        int limb = _lsb64(mask);
+        return _lsb64(limbs[limb]) + limb * 64;
     }
     #pragma endregion
 
+    /**
+     * MARKER Set bit iterator
+     */
+    #pragma region 
+    BitboardIterator<256> begin() const;
+    BitboardIterator<256> end() const;
+    #pragma endregion
+
     /**
      * MARKER Return true if at least one bit is set as true (popCount() > 0)
      */
-    bool has()
+    bool has() const
     {
-        if (is16_16)
-            return main | b | c | d;
-        else
-            return main;
+#if defined(__AVX2__)
+        __m256i v = vector();
+        return !_mm256_testz_si256(v, v);
+#else
+        return (limbs[0] | limbs[1] | limbs[2] | limbs[3]) != 0;
+#endif
     }
 
     /**
      * MARKER Operators
      */
     #pragma region 
+#if defined(__AVX2__)
     //Bitwise & (AND) 
-    Bitboard operator&(const Bitboard &board)
+    Bitboard operator&(const Bitboard &board) const
     {
-        Bitboard b;
-        b.is16_16 = is16_16;
-        b.main = this->main & board.main;
-
-        if (this->is16_16)
-        {
-            b.b = this->b & board.b;
-            b.c = this->c & board.c;
-            b.d = this->d & board.d;
-        }
-        return b;
+        return Bitboard(_mm256_and_si256(vector(), board.vector()));
     }
 
     //Bitwise | (OR)
-    Bitboard operator|(const Bitboard &board)
+    Bitboard operator|(const Bitboard &board) const
     {
-        Bitboard b;
-        b.is16_16 = is16_16;
-        b.main = this->main | board.main;
-
-        if (is16_16)
-        {
-            b.b = this->b | board.b;
-            b.c = this->c | board.c;
-            b.d = this->d | board.d;
-        }
-        return b;
+        return Bitboard(_mm256_or_si256(vector(), board.vector()));
     }
 
     //Bitwise ^ (XOR)
-    Bitboard operator^(const Bitboard &board)
+    Bitboard operator^(const Bitboard &board) const
     {
-        Bitboard b;
-        b.is16_16 = is16_16;
-        b.main = this->main ^ board.main;
+        return Bitboard(_mm256_xor_si256(vector(), board.vector()));
+    }
 
-        if (this->is16_16)
-        {
-            b.b = this->b ^ board.b;
-            b.c = this->c ^ board.c;
-            b.d = this->d ^ board.d;
-        }
-        return b;
+    //Bitwise & ~ (AND NOT)
+    Bitboard andNot(const Bitboard &board) const
+    {
+        return Bitboard(_mm256_andnot_si256(board.vector(), vector()));
     }
 
     //Bitwise Complement/Inverse
-    Bitboard operator~()
+    Bitboard operator~() const
     {
-        Bitboard b;
-        b.is16_16 = is16_16;
-        b.main = ~this->main;
+        return Bitboard(_mm256_xor_si256(vector(), _mm256_set1_epi64x(-1)));
+    }
 
-        if (this->is16_16)
-        {
-            b.b = ~this->b;
-            b.c = ~this->c;
-            b.d = ~this->d;
-        }
-        return b;
+    //Bitwise << (Right Shift), towards higher squares
+    Bitboard operator<<(int move) const
+    {
+        __m256i v = _256shiftLimbsUp(vector(), move / 64);
+        __m128i n = _mm_cvtsi32_si128(move % 64);
+        __m128i carry = _mm_cvtsi32_si128(64 - move % 64);
+
+        //Carry the high bits of each limb into the next one
+        __m256i lower = _256shiftLimbsUp(v, 1);
+        return Bitboard(_mm256_or_si256(_mm256_sll_epi64(v, n), _mm256_srl_epi64(lower, carry)));
     }
 
-    //Bitwise << (Right Shift)
-    Bitboard operator<<(int move)
+    //Bitwise >> (Left Shift), towards lower squares
+    Bitboard operator>>(int move) const
     {
-        Bitboard b;
-        b.is16_16 = is16_16;
-        b.main = this->main << move;
+        __m256i v = _256shiftLimbsDown(vector(), move / 64);
+        __m128i n = _mm_cvtsi32_si128(move % 64);
+        __m128i carry = _mm_cvtsi32_si128(64 - move % 64);
+
+        //Carry the low bits of each limb into the previous one
+        __m256i upper = _256shiftLimbsDown(v, 1);
+        return Bitboard(_mm256_or_si256(_mm256_srl_epi64(v, n), _mm256_sll_epi64(upper, carry)));
+    }
 
-        if (this->is16_16)
+    //Move whole limbs up (limbs[i] = limbs[i - count]) or down (limbs[i] = limbs[i + count])
+    static inline __m256i _256shiftLimbsUp(__m256i v, int count)
+    {
+        switch (count)
         {
-            b.b = this->b << move;
-            b.c = this->c << move;
-            b.d = this->d << move;
+            case 0: return v;
+            case 1: return _mm256_blend_epi32(_mm256_permute4x64_epi64(v, 0x90), _mm256_setzero_si256(), 0x03);
+            case 2: return _mm256_blend_epi32(_mm256_permute4x64_epi64(v, 0x40), _mm256_setzero_si256(), 0x0f);
+            case 3: return _mm256_blend_epi32(_mm256_permute4x64_epi64(v, 0x00), _mm256_setzero_si256(), 0x3f);
+            default: return _mm256_setzero_si256();
         }
-        return b;
     }
 
-    //Bitwise >> (Left Shift)
-    Bitboard operator>>(int move)
+    static inline __m256i _256shiftLimbsDown(__m256i v, int count)
     {
-        Bitboard b;
-        b.is16_16 = is16_16;
-        b.main = this->main >> move;
-
-        if (this->is16_16)
+        switch (count)
         {
-            b.b = this->b >> move;
-            b.c = this->c >> move;
-            b.d = this->d >> move;
+            case 0: return v;
+            case 1: return _mm256_blend_epi32(_mm256_permute4x64_epi64(v, 0xf9), _mm256_setzero_si256(), 0xc0);
+            case 2: return _mm256_blend_epi32(_mm256_permute4x64_epi64(v, 0xfe), _mm256_setzero_si256(), 0xf0);
+            case 3: return _mm256_blend_epi32(_mm256_permute4x64_epi64(v, 0xff), _mm256_setzero_si256(), 0xfc);
+            default: return _mm256_setzero_si256();
         }
-        return b;
     }
 
     //Bitwise | (OR)
     Bitboard &operator|=(const Bitboard &board)
     {
-        this->main |= board.main;
-
-        if (this->is16_16)
-        {
-            this->b |= board.b;
-            this->c |= board.c;
-            this->d |= board.d;
-        }
-
+        _mm256_store_si256((__m256i *)limbs, _mm256_or_si256(vector(), board.vector()));
         return *this;
     }
 
     //Bitwise && (AND)
     Bitboard &operator&=(const Bitboard &board)
     {
-        this->main &= board.main;
-
-        if (this->is16_16)
-        {
-            this->b &= board.b;
-            this->c &= board.c;
-            this->d &= board.d;
-        }
-
+        _mm256_store_si256((__m256i *)limbs, _mm256_and_si256(vector(), board.vector()));
         return *this;
     }
 
     //Bitwise ^ (XOR)
     Bitboard &operator^=(const Bitboard &board)
     {
-        this->main ^= board.main;
-
-        if (this->is16_16)
-        {
-            this->b ^= board.b;
-            this->c ^= board.c;
-            this->d ^= board.d;
-        }
-
+        _mm256_store_si256((__m256i *)limbs, _mm256_xor_si256(vector(), board.vector()));
         return *this;
     }
-    #pragma endregion
-};
+#else
+    //Bitwise & (AND) 
+    constexpr Bitboard operator&(const Bitboard &board) const
+    {
+        return Bitboard(limbs[0] & board.limbs[0], limbs[1] & board.limbs[1], limbs[2] & board.limbs[2], limbs[3] & board.limbs[3]);
+    }
 
-/**
- * MARKER Rays optmization (8x8 and 16x16)
- */
-#pragma region 
-//Rays (8x8)
-Bitboard rays88[8][64];
-//Border (8x8)
-Bitboard border88[64];
-//Border (8x8)
-Bitboard knight88[64];
-//Rays (16x16)
-Bitboard rays1616[8][256];
-//Border (16x16)
-Bitboard border1616[256];
-//Border (16x16)
-Bitboard knight1616[256];
-#pragma endregion
+    //Bitwise | (OR)
+    constexpr Bitboard operator|(const Bitboard &board) const
+    {
+        return Bitboard(limbs[0] | board.limbs[0], limbs[1] | board.limbs[1], limbs[2] | board.limbs[2], limbs[3] | board.limbs[3]);
+    }
 
-/**
- * MARKER Rays/Position generation (8x8 and 16x16)
- */
-#pragma region 
-//Create s 16x16 bitboard
-inline Bitboard _1616s(int square)
-{
-    return Bitboard(_1616calcs(square, 0), _1616calcs(square, 64), _1616calcs(square, 128), _1616calcs(square, 192));
-}
+    //Bitwise ^ (XOR)
+    constexpr Bitboard operator^(const Bitboard &board) const
+    {
+        return Bitboard(limbs[0] ^ board.limbs[0], limbs[1] ^ board.limbs[1], limbs[2] ^ board.limbs[2], limbs[3] ^ board.limbs[3]);
+    }
 
-//Create n 16x16 bitboard
-inline Bitboard _1616n(int square)
-{
-    return Bitboard(_1616calcn(square, 0), _1616calcn(square, 64), _1616calcn(square, 128), _1616calcn(square, 192));
-}
+    //Bitwise & ~ (AND NOT)
+    constexpr Bitboard andNot(const Bitboard &board) const
+    {
+        return Bitboard(limbs[0] & ~board.limbs[0], limbs[1] & ~board.limbs[1], limbs[2] & ~board.limbs[2], limbs[3] & ~board.limbs[3]);
+    }
 
-//Create e 16x16 bitboard
-inline Bitboard _1616e(int square)
-{
-    return Bitboard(_1616calce(square, 0), _1616calce(square, 64), _1616calce(square, 128), _1616calce(square, 192));
-}
+    //Bitwise Complement/Inverse
+    constexpr Bitboard operator~() const
+    {
+        return Bitboard(~limbs[0], ~limbs[1], ~limbs[2], ~limbs[3]);
+    }
 
-//Create w 16x16 bitboard
-inline Bitboard _1616w(int square)
-{
-    return Bitboard(_1616calcw(square, 0), _1616calcw(square, 64), _1616calcw(square, 128), _1616calcw(square, 192));
-}
+    //Bitwise << (Right Shift), towards higher squares
+    constexpr Bitboard operator<<(int move) const
+    {
+        Bitboard result;
+        int limbshift = move / 64;
+        int n = move % 64;
 
-//Create ne 16x16 bitboard
-inline Bitboard _1616ne(int square)
-{
-    U64 a = u64zero;
-    U64 b = u64zero;
-    U64 c = u64zero;
-    U64 d = u64zero;
+        for (int i = 3; i >= limbshift; i--)
+        {
+            U64 value = limbs[i - limbshift] << n;
 
-    int cC = square % 16;
-    int rC = square / 16;
+            //Carry the high bits of the previous limb
+            if (n > 0 && i - limbshift > 0)
+                value |= limbs[i - limbshift - 1] >> (64 - n);
 
-    int s = square + 17;
+            result.limbs[i] = value;
+        }
 
-    int cs = s % 16;
-    int rs = s / 16;
+        return result;
+    }
 
-    while (s < 256 && cs > cC && rs > rC)
+    //Bitwise >> (Left Shift), towards lower squares
+    constexpr Bitboard operator>>(int move) const
     {
-        if (s < 64)
-            a |= u64a1 << (s % 64);
-        else if (s < 128)
-            b |= u64a1 << (s % 64);
-        else if (s < 192)
-            c |= u64a1 << (s % 64);
-        else
-            d |= u64a1 << (s % 64);
+        Bitboard result;
+        int limbshift = move / 64;
+        int n = move % 64;
 
-        s += 17;
-        cs = s % 16;
-        rs = s / 16;
-    }
-
-    return Bitboard(a, b, c, d);
-}
+        for (int i = 0; i < 4 - limbshift; i++)
+        {
+            U64 value = limbs[i + limbshift] >> n;
 
-//Create nw 16x16 bitboard
-inline Bitboard _1616nw(int square)
-{
-    U64 a = u64zero;
-    U64 b = u64zero;
-    U64 c = u64zero;
-    U64 d = u64zero;
+            //Carry the low bits of the next limb
+            if (n > 0 && i + limbshift < 3)
+                value |= limbs[i + limbshift + 1] << (64 - n);
 
-    int cC = square % 16;
-    int rC = square / 16;
+            result.limbs[i] = value;
+        }
 
-    int s = square + 15;
+        return result;
+    }
 
-    int cs = s % 16;
-    int rs = s / 16;
+    //Bitwise | (OR)
+    Bitboard &operator|=(const Bitboard &board)
+    {
+        for (int i = 0; i < 4; i++)
+            limbs[i] |= board.limbs[i];
+        return *this;
+    }
 
-    while (s < 256 && cs < cC && rs > rC)
+    //Bitwise && (AND)
+    Bitboard &operator&=(const Bitboard &board)
     {
-        if (s < 64)
-            a |= u64a1 << (s % 64);
-        else if (s < 128)
-            b |= u64a1 << (s % 64);
-        else if (s < 192)
-            c |= u64a1 << (s % 64);
-        else
-            d |= u64a1 << (s % 64);
+        for (int i = 0; i < 4; i++)
+            limbs[i] &= board.limbs[i];
+        return *this;
+    }
 
-        s += 15;
-        cs = s % 16;
-        rs = s / 16;
+    //Bitwise ^ (XOR)
+    Bitboard &operator^=(const Bitboard &board)
+    {
+        for (int i = 0; i < 4; i++)
+            limbs[i] ^= board.limbs[i];
+        return *this;
     }
+#endif
+    #pragma endregion
+};
 
-    return Bitboard(a, b, c, d);
-}
+/**
+ * MARKER Bitboard types
+ */
+#pragma region 
+typedef Bitboard<64> Bitboard88; //8x8 board
+typedef Bitboard<256> Bitboard1616; //16x16 board
 
-//Create se 16x16 bitboard
-inline Bitboard _1616se(int square)
-{
-    U64 a = u64zero;
-    U64 b = u64zero;
-    U64 c = u64zero;
-    U64 d = u64zero;
+static_assert(sizeof(Bitboard88) == 8, "8x8 bitboard must be a plain U64");
+static_assert(sizeof(Bitboard1616) == 32, "16x16 bitboard must fit a 256 bit register");
+#pragma endregion
 
-    int cC = square % 16;
-    int rC = square / 16;
+/**
+ * MARKER Set bit iterator
+ */
+#pragma region 
+template <int N>
+class BitboardIterator
+{
+public:
+    Bitboard<N> bits;
+    int square;
 
-    int s = square - 15;
+    BitboardIterator(const Bitboard<N> &bits) : bits(bits)
+    {
+        this->square = this->bits.bitScanPopNext();
+    }
 
-    int cs = s % 16;
-    int rs = s / 16;
+    int operator*() const
+    {
+        return square;
+    }
 
-    while (s > 0 && cs > cC && rs < rC)
+    BitboardIterator &operator++()
     {
-        if (s < 64)
-            a |= u64a1 << (s % 64);
-        else if (s < 128)
-            b |= u64a1 << (s % 64);
-        else if (s < 192)
-            c |= u64a1 << (s % 64);
-        else
-            d |= u64a1 << (s % 64);
+        square = bits.bitScanPopNext();
+        return *this;
+    }
 
-        s -= 15;
-        cs = s % 16;
-        rs = s / 16;
+    bool operator!=(const BitboardIterator &other) const
+    {
+        return square != other.square;
     }
+};
 
-    return Bitboard(a, b, c, d);
+inline BitboardIterator<64> Bitboard<64>::begin() const
+{
+    return BitboardIterator<64>(*this);
 }
 
-//Create se 16x16 bitboard
-inline Bitboard _1616sw(int square)
+inline BitboardIterator<64> Bitboard<64>::end() const
 {
-    U64 a = u64zero;
-    U64 b = u64zero;
-    U64 c = u64zero;
-    U64 d = u64zero;
-
-    int cC = square % 16;
-    int rC = square / 16;
-
-    int s = square - 17;
-
-    int cs = s % 16;
-    int rs = s / 16;
-
-    while (s > 0 && cs < cC && rs < rC)
-    {
-        if (s < 64)
-            a |= u64a1 << (s % 64);
-        else if (s < 128)
-            b |= u64a1 << (s % 64);
-        else if (s < 192)
-            c |= u64a1 << (s % 64);
-        else
-            d |= u64a1 << (s % 64);
+    return BitboardIterator<64>(Bitboard<64>());
+}
 
-        s -= 17;
-        cs = s % 16;
-        rs = s / 16;
-    }
+inline BitboardIterator<256> Bitboard<256>::begin() const
+{
+    return BitboardIterator<256>(*this);
+}
 
-    return Bitboard(a, b, c, d);
+inline BitboardIterator<256> Bitboard<256>::end() const
+{
+    return BitboardIterator<256>(Bitboard<256>());
 }
+#pragma endregion
 
+/**
+ * MARKER Rays/Position generation (8x8 and 16x16)
+ */
+#pragma region 
 //Create custom pattern bitboard
-inline Bitboard _88cp(int square, int move, int limit, int column_condition, int row_condition)
+constexpr Bitboard88 _88cp(int square, int move, int limit, int column_condition, int row_condition)
 {
     U64 main = u64zero;
 
@@ -759,7 +718,7 @@ inline Bitboard _88cp(int square, int move, int limit, int column_condition, int
 
     int cn = 0;
 
-    while (s > 0 && s < 64 && cn < limit && (column_condition == 0 ? cs == cC : (column_condition == 1 ? cs > cC : cs < cC)) && (row_condition == 0 ? rs == rC : (row_condition == 1 ? rs > rC : rs < rC)))
+    while (s >= 0 && s < 64 && cn < limit && (column_condition == 0 ? cs == cC : (column_condition == 1 ? cs > cC : cs < cC)) && (row_condition == 0 ? rs == rC : (row_condition == 1 ? rs > rC : rs < rC)))
     {
         main |= u64a1 << s;
 
@@ -769,16 +728,13 @@ inline Bitboard _88cp(int square, int move, int limit, int column_condition, int
         rs = s / 8;
     }
 
-    return Bitboard(main);
+    return Bitboard88(main);
 }
 
 //Create custom pattern bitboard
-inline Bitboard _1616cp(int square, int move, int limit, int column_condition, int row_condition)
+constexpr Bitboard1616 _1616cp(int square, int move, int limit, int column_condition, int row_condition)
 {
-    U64 a = u64zero;
-    U64 b = u64zero;
-    U64 c = u64zero;
-    U64 d = u64zero;
+    U64 limbs[4] = {u64zero, u64zero, u64zero, u64zero};
 
     int cC = square % 16;
     int rC = square / 16;
@@ -790,16 +746,9 @@ inline Bitboard _1616cp(int square, int move, int limit, int column_condition, i
 
     int cn = 0;
 
-    while (s > 0 && s < 256 && cn < limit && (column_condition == 0 ? cs == cC : (column_condition == 1 ? cs > cC : cs < cC)) && (row_condition == 0 ? rs == rC : (row_condition == 1 ? rs > rC : rs < rC)))
+    while (s >= 0 && s < 256 && cn < limit && (column_condition == 0 ? cs == cC : (column_condition == 1 ? cs > cC : cs < cC)) && (row_condition == 0 ? rs == rC : (row_condition == 1 ? rs > rC : rs < rC)))
     {
-        if (s < 64)
-            a |= u64a1 << (s % 64);
-        else if (s < 128)
-            b |= u64a1 << (s % 64);
-        else if (s < 192)
-            c |= u64a1 << (s % 64);
-        else
-            d |= u64a1 << (s % 64);
+        limbs[s / 64] |= u64a1 << (s % 64);
 
         cn++;
         s += move;
@@ -807,8 +756,116 @@ inline Bitboard _1616cp(int square, int move, int limit, int column_condition, i
         rs = s / 16;
     }
 
-    return Bitboard(a, b, c, d);
+    return Bitboard1616(limbs[0], limbs[1], limbs[2], limbs[3]);
+}
+
+//Join 16x16 patterns (Constant evaluated, the AVX2 operators are not)
+constexpr Bitboard1616 _1616join(const Bitboard1616 &a, const Bitboard1616 &b)
+{
+    return Bitboard1616(a.limbs[0] | b.limbs[0], a.limbs[1] | b.limbs[1], a.limbs[2] | b.limbs[2], a.limbs[3] | b.limbs[3]);
 }
 #pragma endregion
 
+/**
+ * MARKER Rays optmization (8x8 and 16x16)
+ * 
+ * Generated at compile time into read-only data, startup does no work
+ */
+#pragma region 
+struct RayTables
+{
+    Bitboard88 rays88[8][64];
+    Bitboard88 border88[64];
+    Bitboard88 knight88[64];
+    Bitboard88 between88[64][64];
+    Bitboard88 line88[64][64];
+    Bitboard1616 rays1616[8][256];
+    Bitboard1616 border1616[256];
+    Bitboard1616 knight1616[256];
+
+    constexpr RayTables() : rays88(), border88(), knight88(), between88(), line88(), rays1616(), border1616(), knight1616()
+    {
+        //8x8 rays
+        for (int square = 0; square < 64; square++)
+        {
+            rays88[NORTH][square] = 0x0101010101010100ULL << square;
+            rays88[SOUTH][square] = 0x0080808080808080ULL >> (63 - square);
+            rays88[EAST][square] = 2 * ((u64a1 << (square | 7)) - (u64a1 << square));
+            rays88[WEST][square] = (u64a1 << square) - (u64a1 << (square & 56));
+            rays88[NORTH_WEST][square] = _westN(0x102040810204000ULL, 7 - _col(square)) << (_row(square) * 8);
+            rays88[NORTH_EAST][square] = _eastN(0x8040201008040200ULL, _col(square)) << (_row(square) * 8);
+            rays88[SOUTH_WEST][square] = _westN(0x40201008040201ULL, 7 - _col(square)) >> ((7 - _row(square)) * 8);
+            rays88[SOUTH_EAST][square] = _eastN(0x2040810204080ULL, _col(square)) >> ((7 - _row(square)) * 8);
+        }
+
+        //8x8 border and knight
+        for (int square = 0; square < 64; square++)
+        {
+            border88[square] = _88cp(square, 9, 1, 1, 1) | _88cp(square, 7, 1, -1, 1) | _88cp(square, -9, 1, -1, -1) | _88cp(square, -7, 1, 1, -1) | _88cp(square, 1, 1, 1, 0) | _88cp(square, 8, 1, 0, 1) | _88cp(square, -1, 1, -1, 0) | _88cp(square, -8, 1, 0, -1);
+            knight88[square] = _88cp(square, 10, 1, 1, 1) | _88cp(square, 17, 1, 1, 1) | _88cp(square, 6, 1, -1, 1) | _88cp(square, 15, 1, -1, 1) |
+                               _88cp(square, -10, 1, -1, -1) | _88cp(square, -6, 1, 1, -1) | _88cp(square, -17, 1, -1, -1) | _88cp(square, -15, 1, 1, -1);
+        }
+
+        //8x8 between (exclusive) and full line of aligned square pairs, empty when not aligned
+        for (int square = 0; square < 64; square++)
+            for (int direction = 0; direction < 8; direction++)
+            {
+                Bitboard88 ray = rays88[direction][square];
+                Bitboard88 line = ray | rays88[(direction + 4) % 8][square] | Bitboard88(u64a1 << square);
+
+                for (int target = 0; target < 64; target++)
+                    if ((ray.main >> target) & 1)
+                    {
+                        between88[square][target] = ray & ~rays88[direction][target] & ~Bitboard88(u64a1 << target);
+                        line88[square][target] = line;
+                    }
+            }
+
+        //16x16 rays, border and knight
+        for (int square = 0; square < 256; square++)
+        {
+            rays1616[NORTH][square] = _1616cp(square, 16, 16, 0, 1);
+            rays1616[SOUTH][square] = _1616cp(square, -16, 16, 0, -1);
+            rays1616[EAST][square] = _1616cp(square, 1, 16, 1, 0);
+            rays1616[WEST][square] = _1616cp(square, -1, 16, -1, 0);
+            rays1616[NORTH_EAST][square] = _1616cp(square, 17, 16, 1, 1);
+            rays1616[NORTH_WEST][square] = _1616cp(square, 15, 16, -1, 1);
+            rays1616[SOUTH_EAST][square] = _1616cp(square, -15, 16, 1, -1);
+            rays1616[SOUTH_WEST][square] = _1616cp(square, -17, 16, -1, -1);
+
+            Bitboard1616 border;
+            const int borderMoves[8][3] = {{17, 1, 1}, {15, -1, 1}, {-17, -1, -1}, {-15, 1, -1}, {1, 1, 0}, {16, 0, 1}, {-1, -1, 0}, {-16, 0, -1}};
+            for (int i = 0; i < 8; i++)
+                border = _1616join(border, _1616cp(square, borderMoves[i][0], 1, borderMoves[i][1], borderMoves[i][2]));
+            border1616[square] = border;
+
+            Bitboard1616 knight;
+            const int knightMoves[8][3] = {{18, 1, 1}, {33, 1, 1}, {14, -1, 1}, {31, -1, 1}, {-18, -1, -1}, {-14, 1, -1}, {-33, -1, -1}, {-31, 1, -1}};
+            for (int i = 0; i < 8; i++)
+                knight = _1616join(knight, _1616cp(square, knightMoves[i][0], 1, knightMoves[i][1], knightMoves[i][2]));
+            knight1616[square] = knight;
+        }
+    }
+};
+
+constexpr RayTables RAY_TABLES = RayTables();
+
+//Rays (8x8)
+constexpr const Bitboard88 (&rays88)[8][64] = RAY_TABLES.rays88;
+//Border (8x8)
+constexpr const Bitboard88 (&border88)[64] = RAY_TABLES.border88;
+//Knight (8x8)
+constexpr const Bitboard88 (&knight88)[64] = RAY_TABLES.knight88;
+//Squares between two aligned squares (8x8)
+constexpr const Bitboard88 (&between88)[64][64] = RAY_TABLES.between88;
+//Line through two aligned squares (8x8)
+constexpr const Bitboard88 (&line88)[64][64] = RAY_TABLES.line88;
+//Rays (16x16)
+constexpr const Bitboard1616 (&rays1616)[8][256] = RAY_TABLES.rays1616;
+//Border (16x16)
+constexpr const Bitboard1616 (&border1616)[256] = RAY_TABLES.border1616;
+//Knight (16x16)
+constexpr const Bitboard1616 (&knight1616)[256] = RAY_TABLES.knight1616;
+#pragma endregion
+
 #endif
\ No newline at end of file
@@ -0,0 +1,191 @@
+/**
+ * 2aCE (Árnilsen's Adaptable Chess Engine)
+ * Copyright (C) 2021 Árnilsen Arthur Castilho Lopes
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef BITBOARD_CHECK_H
+#define BITBOARD_CHECK_H
+
+/**
+ * MARKER Includes
+ */
+#pragma region
+#include <iostream>
+#include "bitboard.hpp"
+#pragma endregion
+
+/**
+ * MARKER 16x16 bitboard check
+ * 
+ * Random boards of different densities are shifted by every count (0-255) and compared
+ * bit by bit with a plain 4x U64 reference, together with the bitwise operators, popCount
+ * and the bit scans. Runs whichever path was compiled (AVX2 or scalar)
+ */
+#pragma region
+const int BITBOARD_CHECK_ROUNDS = 2000;
+
+struct _BitboardReference
+{
+    U64 limbs[4];
+
+    bool get(int s) const
+    {
+        return (limbs[s / 64] >> (s % 64)) & 1;
+    }
+
+    void set(int s)
+    {
+        limbs[s / 64] |= u64a1 << (s % 64);
+    }
+};
+
+//Xorshift generator (Fixed seed, every run checks the same boards)
+inline U64 _bitboardCheckRandom(U64 &state)
+{
+    state ^= state << 13;
+    state ^= state >> 7;
+    state ^= state << 17;
+    return state;
+}
+
+//Dense, sparse or single bit limbs
+inline U64 _bitboardCheckLimb(U64 &state, int density)
+{
+    if(density == 0)
+        return _bitboardCheckRandom(state);
+    if(density == 1)
+        return _bitboardCheckRandom(state) & _bitboardCheckRandom(state) & _bitboardCheckRandom(state);
+    return (_bitboardCheckRandom(state) & 3) == 0 ? u64a1 << (_bitboardCheckRandom(state) & 63) : 0;
+}
+
+inline bool _bitboardCheckSame(const Bitboard1616 &board, const _BitboardReference &reference)
+{
+    for(int i = 0; i < 4; i ++)
+        if(board.limbs[i] != reference.limbs[i])
+            return false;
+    return true;
+}
+
+//Shift a single square at a time
+inline _BitboardReference _bitboardCheckShift(const _BitboardReference &board, int move, bool left)
+{
+    _BitboardReference result = {{0, 0, 0, 0}};
+
+    for(int s = 0; s < 256; s ++)
+    {
+        int to = left ? s + move : s - move;
+        if(board.get(s) && to >= 0 && to < 256)
+            result.set(to);
+    }
+
+    return result;
+}
+
+//Returns false on the first mismatch (Printed to out)
+bool runBitboardCheck(std::ostream &out = std::cout, int rounds = BITBOARD_CHECK_ROUNDS)
+{
+    U64 state = 0x9e3779b97f4a7c15ULL;
+    int checks = 0;
+
+    for(int round = 0; round < rounds; round ++)
+    {
+        _BitboardReference a, b;
+        for(int i = 0; i < 4; i ++)
+        {
+            a.limbs[i] = _bitboardCheckLimb(state, round % 3);
+            b.limbs[i] = _bitboardCheckLimb(state, (round / 3) % 3);
+        }
+
+        Bitboard1616 x(a.limbs[0], a.limbs[1], a.limbs[2], a.limbs[3]);
+        Bitboard1616 y(b.limbs[0], b.limbs[1], b.limbs[2], b.limbs[3]);
+
+        //Shifts carry across limbs for every count
+        for(int move = 0; move < 256; move ++)
+        {
+            if(!_bitboardCheckSame(x << move, _bitboardCheckShift(a, move, true)) || !_bitboardCheckSame(x >> move, _bitboardCheckShift(a, move, false)))
+            {
+                out << "[FAIL] Bitboard<256> shift by " << move << " (Round " << round << ")\n";
+                return false;
+            }
+            checks += 2;
+        }
+
+        //Bitwise operators
+        _BitboardReference both, either, other, without, inverse;
+        for(int i = 0; i < 4; i ++)
+        {
+            both.limbs[i] = a.limbs[i] & b.limbs[i];
+            either.limbs[i] = a.limbs[i] | b.limbs[i];
+            other.limbs[i] = a.limbs[i] ^ b.limbs[i];
+            without.limbs[i] = a.limbs[i] & ~b.limbs[i];
+            inverse.limbs[i] = ~a.limbs[i];
+        }
+
+        Bitboard1616 z = x;
+        z ^= y;
+        if(!_bitboardCheckSame(x & y, both) || !_bitboardCheckSame(x | y, either) || !_bitboardCheckSame(x ^ y, other) ||
+           !_bitboardCheckSame(x.andNot(y), without) || !_bitboardCheckSame(~x, inverse) || !_bitboardCheckSame(z, other))
+        {
+            out << "[FAIL] Bitboard<256> operators (Round " << round << ")\n";
+            return false;
+        }
+        checks += 6;
+
+        //Counts and scans
+        int count = 0, first = -1, last = -1;
+        for(int s = 0; s < 256; s ++)
+            if(a.get(s))
+            {
+                count ++;
+                last = s;
+                if(first == -1)
+                    first = s;
+            }
+
+        if(x.popCount() != count || x.bitScanForward() != first || x.bitScanReverse() != last || x.has() != (count > 0))
+        {
+            out << "[FAIL] Bitboard<256> popCount/bit scans (Round " << round << ")\n";
+            return false;
+        }
+
+        //Popping visits the squares in order
+        Bitboard1616 pop = x;
+        for(int s = 0; s < 256; s ++)
+            if(a.get(s) && pop.bitScanPopNext() != s)
+            {
+                out << "[FAIL] Bitboard<256> bitScanPopNext (Round " << round << ")\n";
+                return false;
+            }
+
+        if(pop.bitScanPopNext() != -1)
+        {
+            out << "[FAIL] Bitboard<256> bitScanPopNext (Round " << round << ")\n";
+            return false;
+        }
+        checks += 5;
+    }
+
+#if defined(__AVX2__)
+    const char *path = "AVX2";
+#else
+    const char *path = "scalar";
+#endif
+
+    out << "[OK]   Bitboard<256>: " << checks << " checks (" << path << ")\n";
+    return true;
+}
+#pragma endregion
+#endif
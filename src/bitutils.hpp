@@ -20,10 +20,10 @@
 #define BITUTILS_H
 
 /**
- * MARKER Util to generate U64 rays values (8x8 and 16x16)
+ * MARKER Util to generate U64 rays values (8x8)
  */
 #pragma region 
-inline U64 _eastN(U64 board, U8 n)
+constexpr U64 _eastN(U64 board, U8 n)
 {
     U64 newBoard = board;
     for (U8 i = 0; i < n; i++)
@@ -32,7 +32,7 @@ inline U64 _eastN(U64 board, U8 n)
     return newBoard;
 }
 
-inline U64 _westN(U64 board, U8 n)
+constexpr U64 _westN(U64 board, U8 n)
 {
     U64 newBoard = board;
     for (U8 i = 0; i < n; i++)
@@ -41,56 +41,14 @@ inline U64 _westN(U64 board, U8 n)
     return newBoard;
 }
 
-inline U8 _row(U8 square)
+constexpr U8 _row(U8 square)
 {
     return square / 8;
 }
 
-inline U8 _col(U8 square)
+constexpr U8 _col(U8 square)
 {
     return square % 8;
 }
-
-//Calc north coordinates of 16x16
-inline U64 _1616calcn(U8 square, U8 min)
-{
-    U64 a = 0x01000100010001;
-    if (square < min)
-        return a << (square % 16);
-
-    if (square + 16 >= min + 64)
-        return 0;
-
-    return a << square + 16;
-}
-
-//Calc south coordinates of 16x16
-inline U64 _1616calcs(U8 square, U8 min)
-{
-    U64 a = 0x01000100010001;
-    if (square <= min)
-        return 0;
-
-    if (64 <= (square - min))
-        return a << (-(64 - (square - min))) % 16;
-
-    return a >> 64 - (square - min);
-}
-
-inline U64 _1616calce(U8 square, U8 min)
-{
-    if (square < min || square >= min + 64)
-        return 0;
-
-    return 2 * ((u64a1 << (square | 15)) - (u64a1 << square));
-}
-
-inline U64 _1616calcw(U8 square, U8 min)
-{
-    if (square < min || square >= min + 64)
-        return 0;
-
-    return (u64a1 << square) - (u64a1 << (square & 240));
-}
 #pragma endregion
 #endif
\ No newline at end of file
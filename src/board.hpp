@@ -24,13 +24,22 @@
  */
 #pragma region 
 #include <string>
+#include <cstring>
 #include "bitboard.hpp"
 #include "move.hpp"
 #pragma endregion
 
 /**
- * Base class for a board game (8x8 or 16x16)
+ * MARKER Mailbox
  */
+#pragma region
+const U8 NO_PIECE = 255; //Empty square / Missing piece type
+#pragma endregion
+
+/**
+ * Base class for a board game (N = 64 for 8x8 or 256 for 16x16)
+ */
+template <int N>
 class Board
 {
 public:
@@ -38,16 +47,18 @@ public:
      * MARKER Fields
      */
     #pragma region 
-    Bitboard valid; //Holds all valid squares (For custom shaped games)
+    Bitboard<N> valid; //Holds all valid squares (For custom shaped games)
     U8 currentPlayer;
 
     //Data
-    Bitboard _pieces[8][13]; //Pieces types + All pieces
-    Bitboard _occupied;
-    Bitboard _notoccupied;
+    Bitboard<N> _pieces[8][13]; //Pieces types + All pieces
+    Bitboard<N> _occupied;
+    Bitboard<N> _notoccupied;
+
+    //Piece on each square (Type | Player << 4), kept in sync with the bitboards
+    U8 _mailbox[N];
 
     //Moves
-    MoveList moves;
     MoveList legalMoves;
     #pragma endregion
     
@@ -57,6 +68,34 @@ public:
     #pragma region 
     Board()
     {
+        _clearMailbox();
+    }
+    #pragma endregion
+
+    /**
+     * MARKER Mailbox
+     */
+    #pragma region
+    static constexpr U8 _mailboxPiece(U8 player, U8 piecetype)
+    {
+        return piecetype | (player << 4);
+    }
+
+    void _clearMailbox()
+    {
+        memset(_mailbox, NO_PIECE, sizeof(_mailbox));
+    }
+
+    //Piece type on a square for any player (NO_PIECE when empty)
+    U8 pieceTypeOn(int pos) const
+    {
+        return _mailbox[pos] == NO_PIECE ? NO_PIECE : _mailbox[pos] & 15;
+    }
+
+    //Owner of the piece on a square (NO_PIECE when empty)
+    U8 playerOn(int pos) const
+    {
+        return _mailbox[pos] == NO_PIECE ? NO_PIECE : _mailbox[pos] >> 4;
     }
     #pragma endregion
     
@@ -77,8 +116,8 @@ public:
 
     //Moves
     virtual void genMoves() = 0;
-    virtual void doMove(Move &move) = 0;
-    virtual void undoMove(Move &move) = 0;
+    virtual void doMove(Move move) = 0;
+    virtual void undoMove(Move move) = 0;
 
     //I/O Moves
     virtual void stringifyMove(Move move,std::string &output) = 0;
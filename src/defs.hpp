@@ -32,6 +32,7 @@
  */
 #pragma region 
 typedef unsigned long long U64; //Default 64 bit integer implementation (Board)
+typedef unsigned short U16; //Default 16 bit integer implementation (Packed moves)
 typedef unsigned char U8; //Default 8 bit integer implementation (Ids and positions)
 #pragma endregion
 
@@ -0,0 +1,135 @@
+/**
+ * 2aCE (Árnilsen's Adaptable Chess Engine)
+ * Copyright (C) 2021 Árnilsen Arthur Castilho Lopes
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef INTRINSICS_H
+#define INTRINSICS_H
+
+/**
+ * MARKER Includes
+ */
+#pragma region 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#include <immintrin.h>
+#elif defined(__BMI__) || defined(__BMI2__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+#pragma endregion
+
+/**
+ * MARKER Portable bit intrinsics
+ * 
+ * MSVC intrinsics, GCC/Clang builtins or BMI1 instructions (When compiled with -mbmi)
+ */
+#pragma region 
+#if defined(_MSC_VER)
+#pragma intrinsic(_BitScanReverse64)
+#pragma intrinsic(_BitScanForward64)
+#endif
+
+//Index of the lowest set bit (Undefined for 0)
+inline int _lsb64(U64 value)
+{
+#if defined(_MSC_VER)
+    unsigned long pos;
+    _BitScanForward64(&pos, value);
+    return (int)pos;
+#elif defined(__BMI__)
+    return (int)_tzcnt_u64(value);
+#else
+    return __builtin_ctzll(value);
+#endif
+}
+
+//Index of the highest set bit (Undefined for 0)
+inline int _msb64(U64 value)
+{
+#if defined(_MSC_VER)
+    unsigned long pos;
+    _BitScanReverse64(&pos, value);
+    return (int)pos;
+#else
+    return 63 ^ __builtin_clzll(value);
+#endif
+}
+
+//Count all set bits
+inline int _bitcount64(U64 value)
+{
+#if defined(_MSC_VER)
+    return (int)__popcnt64(value);
+#else
+    return __builtin_popcountll(value);
+#endif
+}
+
+//Reset the lowest set bit
+inline U64 _resetlsb64(U64 value)
+{
+#if defined(__BMI__) && !defined(_MSC_VER)
+    return _blsr_u64(value);
+#else
+    return value & (value - 1);
+#endif
+}
+
+//Bring a cache line closer (Hint only, no effect on the result)
+inline void _prefetch(const void *address)
+{
+#if defined(_MSC_VER)
+    _mm_prefetch((const char *)address, _MM_HINT_T0);
+#else
+    __builtin_prefetch(address);
+#endif
+}
+#pragma endregion
+
+/**
+ * MARKER BMI2 support
+ * 
+ * PEXT is emitted directly so one binary can pick it at runtime
+ */
+#pragma region 
+inline U64 _pext64(U64 value, U64 mask)
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    return _pext_u64(value, mask);
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+    U64 result;
+    __asm__("pextq %2, %1, %0" : "=r"(result) : "r"(value), "r"(mask));
+    return result;
+#else
+    return 0; //Never selected (cpuHasBMI2() is false)
+#endif
+}
+
+inline bool cpuHasBMI2()
+{
+#if defined(_MSC_VER) && defined(_M_X64)
+    int info[4];
+    __cpuidex(info, 7, 0);
+    return (info[1] >> 8) & 1;
+#elif (defined(__GNUC__) || defined(__clang__)) && defined(__x86_64__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("bmi2");
+#else
+    return false;
+#endif
+}
+#pragma endregion
+#endif
\ No newline at end of file
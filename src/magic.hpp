@@ -0,0 +1,248 @@
+/**
+ * 2aCE (Árnilsen's Adaptable Chess Engine)
+ * Copyright (C) 2021 Árnilsen Arthur Castilho Lopes
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MAGIC_H
+#define MAGIC_H
+
+/**
+ * MARKER Includes
+ */
+#pragma region 
+#include "bitboard.hpp"
+#pragma endregion
+
+/**
+ * MARKER Slider backends
+ */
+#pragma region 
+enum SliderBackend
+{
+    SLIDER_MAGIC = 0, //Portable magic multiplication
+    SLIDER_PEXT = 1 //BMI2 parallel bit extract
+};
+
+const char *sliderBackendNames[2] = {"magic", "pext (BMI2)"};
+
+//Selected once by initMagics(), generators are instantiated for each backend and dispatch on it at their entry
+SliderBackend sliderBackend = SLIDER_MAGIC;
+#pragma endregion
+
+/**
+ * MARKER Magic entry (8x8)
+ * 
+ * Holds the relevant occupancy mask of a square and the multiplier that maps every
+ * occupancy subset of that mask into a perfect index of the square attack table.
+ * With the PEXT backend the mask bits are extracted directly and the multiplier is unused
+ */
+struct Magic
+{
+    U64 mask; //Relevant occupancy (Ray squares without board edges)
+    U64 magic; //Magic multiplier
+    U64 *attacks; //Attack table of the square
+    U8 shift; //64 - relevant bits
+
+    template <SliderBackend Backend>
+    inline unsigned int index(U64 occupied) const
+    {
+        if constexpr (Backend == SLIDER_PEXT)
+            return (unsigned int)_pext64(occupied, mask);
+        else
+            return (unsigned int)(((occupied & mask) * magic) >> shift);
+    }
+};
+
+/**
+ * MARKER Magic numbers (8x8)
+ */
+#pragma region 
+const U64 ROOK_MAGICS[64] = {
+    0x1080004008801020ULL, 0x840092002c03000ULL, 0x1900200010400900ULL, 0x880100008000480ULL,
+    0x4200100420080200ULL, 0x8100020100080400ULL, 0x200040110886200ULL, 0x200008040220411ULL,
+    0x404800084400220ULL, 0x401000402000ULL, 0x86001081220440ULL, 0x408800800100280ULL,
+    0xa001201040820ULL, 0x8848800200840080ULL, 0x4001000100040200ULL, 0x442000102105084ULL,
+    0x9080010020804100ULL, 0x40404000201009ULL, 0x808010002009ULL, 0x2200090021d00100ULL,
+    0x8008008040080ULL, 0x4004002010040ULL, 0x11040008015042ULL, 0xa0001768104ULL,
+    0x800080204009ULL, 0x2010004140002001ULL, 0x9800200280100080ULL, 0x1000100080080080ULL,
+    0x442000a00049020ULL, 0x2100040080020080ULL, 0x800120400900148ULL, 0x10040a00128541ULL,
+    0x2800804000800030ULL, 0x1010002000400041ULL, 0x4000200011004100ULL, 0x610008410800800ULL,
+    0x400802402800800ULL, 0xc100020080800400ULL, 0x2000802000401ULL, 0x182085882000401ULL,
+    0x220204000808000ULL, 0x2860100040024022ULL, 0x1002004110040ULL, 0x99101042000a0020ULL,
+    0x4080004008080ULL, 0x10040002008080ULL, 0x2012004881020004ULL, 0x8300842444820011ULL,
+    0x88403882010200ULL, 0x820400080210100ULL, 0x110910040a00300ULL, 0x801100280080480ULL,
+    0x242009008200600ULL, 0x1002000489500200ULL, 0x40800200010080ULL, 0x91800041000080ULL,
+    0x209300488001ULL, 0x4c1002414824001ULL, 0x20020000b001041ULL, 0x7000100004200901ULL,
+    0x8002002004100802ULL, 0x30010002084c0007ULL, 0x888221800813004ULL, 0x4000002840840112ULL
+};
+
+const U64 BISHOP_MAGICS[64] = {
+    0xa010041108003100ULL, 0x6082020a002900ULL, 0x6810010619200000ULL, 0x8281a0520000408ULL,
+    0x1104001000400ULL, 0x18901008048400ULL, 0x40a0210245280ULL, 0x200210808a402ULL,
+    0x9140048410821200ULL, 0x800091010820041ULL, 0x20504804832202c0ULL, 0x100091401081000ULL,
+    0x8021011140000012ULL, 0x810020804450400ULL, 0x208b0542109008a2ULL, 0x80084a08040204ULL,
+    0x40e2a80811244cULL, 0x2505022008008108ULL, 0x430220100420040ULL, 0x10a040420220040ULL,
+    0x1105000290400000ULL, 0x93001200822120ULL, 0x4000a62048043004ULL, 0x280120048a015004ULL,
+    0x6090002a020814ULL, 0x44042000240800d0ULL, 0x1102800040a4400ULL, 0x1004080080220040ULL,
+    0x1001011004024ULL, 0x10044000805040ULL, 0x914041200820100ULL, 0x4821012821480ULL,
+    0x24040500c05021ULL, 0x88611002080200ULL, 0x116080a00040020ULL, 0x4000020080080080ULL,
+    0x2450450140840040ULL, 0x880201484100ULL, 0x222020404020092ULL, 0x8081110600002e00ULL,
+    0x2842101105000801ULL, 0x1100809008001025ULL, 0x20202221c0400ULL, 0x422014022009020ULL,
+    0x210046102100c00ULL, 0xc004008082029102ULL, 0xaa461801101200ULL, 0x404080080201108ULL,
+    0x20542108c205002ULL, 0x410544804100100ULL, 0x40910841100000ULL, 0x400200042021100ULL,
+    0x4204850400c0ULL, 0x200100410a42102ULL, 0x1040020801210102ULL, 0x805040410420000ULL,
+    0x2884804130100200ULL, 0x800c262201242000ULL, 0x1058000194108800ULL, 0x14221054420204ULL,
+    0x104000012a02200ULL, 0x200881003300100ULL, 0x140400202840100ULL, 0x402020801010201ULL
+};
+#pragma endregion
+
+/**
+ * MARKER Slider attack tables (8x8)
+ */
+#pragma region 
+//Rook magics (8x8)
+Magic rookMagics88[64];
+//Bishop magics (8x8)
+Magic bishopMagics88[64];
+//Rook attacks (8x8)
+U64 rookAttacks88[102400];
+//Bishop attacks (8x8)
+U64 bishopAttacks88[5248];
+#pragma endregion
+
+/**
+ * MARKER Slider attack generation (8x8)
+ * 
+ * Slow ray walk, used only to fill the magic tables
+ */
+#pragma region 
+inline U64 _88rayAttacks(int square, U64 occupied, Direction direction, bool reverse)
+{
+    U64 ray = rays88[direction][square].main;
+    U64 blockers = ray & occupied;
+
+    if(blockers)
+    {
+        int blockindex = reverse ? _msb64(blockers) : _lsb64(blockers);
+        ray &= ~rays88[direction][blockindex].main;
+    }
+
+    return ray;
+}
+
+inline U64 _88rookAttacks(int square, U64 occupied)
+{
+    return _88rayAttacks(square, occupied, NORTH, false) | _88rayAttacks(square, occupied, SOUTH, true) | _88rayAttacks(square, occupied, EAST, false) | _88rayAttacks(square, occupied, WEST, true);
+}
+
+inline U64 _88bishopAttacks(int square, U64 occupied)
+{
+    return _88rayAttacks(square, occupied, NORTH_EAST, false) | _88rayAttacks(square, occupied, SOUTH_EAST, true) | _88rayAttacks(square, occupied, NORTH_WEST, false) | _88rayAttacks(square, occupied, SOUTH_WEST, true);
+}
+
+inline U64 _88rookMask(int square)
+{
+    return (rays88[NORTH][square].main & ~0xff00000000000000ULL) | (rays88[SOUTH][square].main & ~0xffULL) |
+           (rays88[EAST][square].main & ~FILE_H) | (rays88[WEST][square].main & ~FILE_A);
+}
+
+inline U64 _88bishopMask(int square)
+{
+    const U64 EDGES = 0xff000000000000ffULL | FILE_A | FILE_H;
+
+    return (rays88[NORTH_EAST][square].main | rays88[SOUTH_EAST][square].main | rays88[NORTH_WEST][square].main | rays88[SOUTH_WEST][square].main) & ~EDGES;
+}
+
+//Fill a magic table (Requires rays88)
+template <SliderBackend Backend>
+inline int _initMagics(Magic magics[64], const U64 numbers[64], U64 *table, U64 (*mask)(int), U64 (*attacks)(int, U64))
+{
+    U64 *next = table;
+
+    for (int square = 0; square < 64; square++)
+    {
+        Magic &m = magics[square];
+        m.mask = mask(square);
+        m.magic = numbers[square];
+        m.shift = 64 - Bitboard88(m.mask).popCount();
+        m.attacks = next;
+
+        //Carry-rippler: walk every subset of the mask
+        U64 occupied = 0;
+        int size = 0;
+        do
+        {
+            m.attacks[m.index<Backend>(occupied)] = attacks(square, occupied);
+            occupied = (occupied - m.mask) & m.mask;
+            size++;
+        } while (occupied);
+
+        next += size;
+    }
+
+    return next - table;
+}
+
+template <SliderBackend Backend>
+inline int _initAllMagics()
+{
+    return _initMagics<Backend>(rookMagics88, ROOK_MAGICS, rookAttacks88, _88rookMask, _88rookAttacks) +
+           _initMagics<Backend>(bishopMagics88, BISHOP_MAGICS, bishopAttacks88, _88bishopMask, _88bishopAttacks);
+}
+
+//Generate all slider attack tables (Both backends share the same table size)
+//PEXT is used on BMI2 CPUs unless disallowed or compiled with FORCE_MAGIC
+inline int initMagics(bool allowPext = true)
+{
+#ifdef FORCE_MAGIC
+    allowPext = false;
+#endif
+    sliderBackend = (allowPext && cpuHasBMI2()) ? SLIDER_PEXT : SLIDER_MAGIC;
+
+    return sliderBackend == SLIDER_PEXT ? _initAllMagics<SLIDER_PEXT>() : _initAllMagics<SLIDER_MAGIC>();
+}
+#pragma endregion
+
+/**
+ * MARKER Slider attacks (8x8)
+ * 
+ * One table lookup per piece, independent of how many rays are covered
+ */
+#pragma region 
+template <SliderBackend Backend>
+inline Bitboard88 rookAttacks(int square, const Bitboard88 &occupied)
+{
+    const Magic &m = rookMagics88[square];
+    return Bitboard88(m.attacks[m.index<Backend>(occupied.main)]);
+}
+
+template <SliderBackend Backend>
+inline Bitboard88 bishopAttacks(int square, const Bitboard88 &occupied)
+{
+    const Magic &m = bishopMagics88[square];
+    return Bitboard88(m.attacks[m.index<Backend>(occupied.main)]);
+}
+
+template <SliderBackend Backend>
+inline Bitboard88 queenAttacks(int square, const Bitboard88 &occupied)
+{
+    const Magic &r = rookMagics88[square];
+    const Magic &b = bishopMagics88[square];
+    return Bitboard88(r.attacks[r.index<Backend>(occupied.main)] | b.attacks[b.index<Backend>(occupied.main)]);
+}
+#pragma endregion
+
+#endif
\ No newline at end of file
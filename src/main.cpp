@@ -38,7 +38,6 @@
  */
 #pragma region
 #include <iostream>
-#include <intrin.h>
 #include <sstream>
 #include <bitset>
 #include <chrono>
@@ -46,8 +45,15 @@
 #include <time.h>
 #include "defs.hpp"
 #include "bitboard.hpp"
+#include "bitboardcheck.hpp"
+#include "magic.hpp"
 #include "board.hpp"
 #include "standard/standard.hpp"
+#include "standard/movepicker.hpp"
+#include "tt.hpp"
+#include "standard/perft.hpp"
+#include "standard/search.hpp"
+#include "standard/smp.hpp"
 #pragma endregion
 
 /**
@@ -56,64 +62,134 @@
 using namespace std;
 
 /**
- * Generate all rays (Optmization)
+ * Generate all slider attacks (Ray tables are generated at compile time)
  */
 #pragma region
-void initRays()
+void initRays(bool allowPext)
 {
     auto start = chrono::steady_clock::now();
-    //8x8 rays
-    for (int square = 0; square < 64; square++)
-    {
-        rays88[NORTH][square] = 0x0101010101010100ULL << square;
-        rays88[SOUTH][square] = 0x0080808080808080ULL >> (63 - square);
-        rays88[EAST][square] = 2 * ((u64a1 << (square | 7)) - (u64a1 << square));
-        rays88[WEST][square] = (u64a1 << square) - (u64a1 << (square & 56));
-        rays88[NORTH_WEST][square] = _westN(0x102040810204000ULL, 7 - _col(square)) << (_row(square) * 8);
-        rays88[NORTH_EAST][square] = _eastN(0x8040201008040200ULL, _col(square)) << (_row(square) * 8);
-        rays88[SOUTH_WEST][square] = _westN(0x40201008040201ULL, 7 - _col(square)) >> ((7 - _row(square)) * 8);
-        rays88[SOUTH_EAST][square] = _eastN(0x2040810204080ULL, _col(square)) >> ((7 - _row(square)) * 8);
-    }
 
-    //8x8 border
-    for (int square = 0; square < 256; square++)
-    {
-        border88[square] = _88cp(square, 9, 1, 1, 1) | _88cp(square, 7, 1, -1, 1) | _88cp(square, -9, 1, -1, -1) | _88cp(square, -7, 1, 1, -1) | _88cp(square, 1, 1, 1, 0) | _88cp(square, 8, 1, 0, 1) | _88cp(square, -1, 1, -1, 0) | _88cp(square, -8, 1, 0, -1);
-    }
+    //8x8 slider attacks (Layout depends on the CPU backend)
+    int sliders = initMagics(allowPext);
 
-    for (int square = 0; square < 64; square++)
-    {
-        knight88[square] = _88cp(square, 10, 1, 1, 1) | _88cp(square, 17, 1, 1, 1) | _88cp(square, 6, 1, -1, 1) | _88cp(square, 15, 1, -1, 1) |
-                           _88cp(square, -10, 1, -1, -1) | _88cp(square, -6, 1, 1, -1) | _88cp(square, -17, 1, -1, -1) | _88cp(square, -15, 1, 1, -1);
-    }
+    auto end = chrono::steady_clock::now();
+    std::cout << sliders << " slider attacks generated in " << chrono::duration_cast<chrono::microseconds>(end - start).count() / 1000.0 << "ms (" << sliderBackendNames[sliderBackend] << ")" << endl;
+}
+#pragma endregion
+
+/**
+ * MARKER Command line modes
+ * 
+ * 2ace perft <depth> [fen] [-t threads] [-h cacheMB]
+ * 2ace divide <depth> [fen] [-t threads] [-h cacheMB]
+ * 2ace bench [-t threads] [-h cacheMB]
+ * 2ace check
+ * 2ace search <depth> [fen] [-m movetimeMs] [-n nodes] [-t threads] [-h hashMB] [-smp lazy|abdada]
+ * 
+ * -magic forces the portable magic slider backend in any mode (Handled before the rays are generated)
+ */
+#pragma region
+int printUsage()
+{
+    cout << "Usage: 2ace [perft <depth> [fen] | divide <depth> [fen] | bench | check] [-t threads] [-h cacheMB] [-magic]" << endl;
+    cout << "       2ace search <depth> [fen] [-m movetimeMs] [-n nodes] [-t threads] [-h hashMB] [-smp lazy|abdada]" << endl;
+    return 1;
+}
 
-    for (int square = 0; square < 256; square++)
+int runCommand(int argc, char **argv)
+{
+    std::string mode = argv[1];
+
+    //Thread count, cache/hash size and search limit options, everything else is positional
+    int threads = 1;
+    int cacheMB = 0;
+    SearchLimits limits;
+    int smpMode = SMP_LAZY;
+    std::vector<std::string> args;
+    for(int i = 2; i < argc; i ++)
     {
-        knight1616[square] = _1616cp(square, 18, 1, 1, 1) | _1616cp(square, 33, 1, 1, 1) | _1616cp(square, 14, 1, -1, 1) | _1616cp(square, 31, 1, -1, 1) |
-                             _1616cp(square, -18, 1, -1, -1) | _1616cp(square, -14, 1, 1, -1) | _1616cp(square, -33, 1, -1, -1) | _1616cp(square, -31, 1, 1, -1);
+        if(std::string(argv[i]) == "-t" && i + 1 < argc)
+            threads = atoi(argv[++i]);
+        else if(std::string(argv[i]) == "-h" && i + 1 < argc)
+            cacheMB = atoi(argv[++i]);
+        else if(std::string(argv[i]) == "-m" && i + 1 < argc)
+            limits.timeMs = atoi(argv[++i]);
+        else if(std::string(argv[i]) == "-n" && i + 1 < argc)
+            limits.nodes = strtoull(argv[++i], nullptr, 10);
+        else if(std::string(argv[i]) == "-smp" && i + 1 < argc)
+        {
+            std::string name = argv[++i];
+            if(name == SMP_MODE_NAMES[SMP_LAZY])
+                smpMode = SMP_LAZY;
+            else if(name == SMP_MODE_NAMES[SMP_ABDADA])
+                smpMode = SMP_ABDADA;
+            else
+                return printUsage();
+        }
+        else if(std::string(argv[i]) == "-magic")
+            continue;
+        else
+            args.push_back(argv[i]);
     }
 
-    //16x16 rays
-    for (int square = 0; square < 256; square++)
+    std::unique_ptr<StandardPerftCache> cache;
+    if(cacheMB > 0 && mode != "search")
+        cache.reset(new StandardPerftCache(cacheMB));
+
+    if(mode == "bench")
     {
-        rays1616[NORTH][square] = _1616n(square);
-        rays1616[SOUTH][square] = _1616s(square);
-        rays1616[EAST][square] = _1616e(square);
-        rays1616[WEST][square] = _1616w(square);
-        rays1616[NORTH_EAST][square] = _1616ne(square);
-        rays1616[NORTH_WEST][square] = _1616nw(square);
-        rays1616[SOUTH_EAST][square] = _1616se(square);
-        rays1616[SOUTH_WEST][square] = _1616sw(square);
+        bool passed = runPerftSuite(threads, cache.get());
+        cout << "\n";
+        passed &= runSeeSuite();
+        return passed ? 0 : 1;
     }
 
-    //16x16 border
-    for (int square = 0; square < 256; square++)
+    if(mode == "check")
+        return runBitboardCheck() ? 0 : 1;
+
+    if((mode == "perft" || mode == "divide" || mode == "search") && args.size() >= 1)
     {
-        border1616[square] = (_1616cp(square, 17, 1, 1, 1) | _1616cp(square, 15, 1, -1, 1) | _1616cp(square, -17, 1, -1, -1) | _1616cp(square, -15, 1, 1, -1) | _1616cp(square, 1, 1, 1, 0) | _1616cp(square, 16, 1, 0, 1) | _1616cp(square, -1, 1, -1, 0) | _1616cp(square, -16, 1, 0, -1));
+        StandardBoard board;
+
+        //Remaining arguments form the FEN (Start position by default)
+        if(args.size() >= 2)
+        {
+            std::string fen = args[1];
+            for(size_t i = 2; i < args.size(); i ++)
+                fen += " " + args[i];
+
+            std::string status;
+            board.loadBoard(fen, status);
+            if(status.rfind("Error", 0) == 0)
+            {
+                cout << status << endl;
+                return 1;
+            }
+        }
+
+        if(mode == "search")
+        {
+            TranspositionTable tt(cacheMB > 0 ? cacheMB : TT_DEFAULT_MB);
+            StandardSearchPool pool(tt, threads, &cout, smpMode);
+
+            limits.depth = atoi(args[0].c_str());
+            SearchResult result = pool.search(board, limits);
+
+            std::string name = "(none)";
+            if(result.bestMove.isValid())
+            {
+                board.doMove(result.bestMove);
+                board.stringifyMove(result.bestMove, name);
+            }
+            cout << "bestmove " << name << " (" << result.nodes << " nodes in " << result.ms << "ms)" << endl;
+            return 0;
+        }
+
+        runPerft(board, atoi(args[0].c_str()), mode == "divide", threads, cache.get());
+        return 0;
     }
 
-    auto end = chrono::steady_clock::now();
-    std::cout << 64 * 8 + 256 * 8 + 256 + 64 + 256 + 64 << " rays generated in " << chrono::duration_cast<chrono::microseconds>(end - start).count() / 1000.0 << "ms" << endl;
+    return printUsage();
 }
 #pragma endregion
 
@@ -121,16 +197,27 @@ void initRays()
  * MARKER Main engine entry
  */
 #pragma region
-int main()
+int main(int argc, char **argv)
 {
+    //Slider backend has to be known before the tables are filled
+    bool allowPext = true;
+    for (int i = 1; i < argc; i++)
+        if(std::string(argv[i]) == "-magic")
+            allowPext = false;
+
     //Init all rays
-    initRays();
+    initRays(allowPext);
+
+    if(argc > 1)
+        return runCommand(argc, argv);
 
-    //Create board
+    //Create board and engine
     StandardBoard board;
+    TranspositionTable tt;
+    StandardSearch engine(board, tt);
 
-    //Seed
-    srand (time(NULL));
+    SearchLimits limits;
+    limits.timeMs = SEARCH_DEFAULT_TIME;
 
     board.print();
     cout << "\nYour Turn:\n";
@@ -167,22 +254,19 @@ int main()
         #pragma endregion
 
         #pragma region Computer
-        auto start = chrono::steady_clock::now();  
-        board.genMoves();
-        if(board.legalMoves.size() == 0)
+        SearchResult result = engine.search(limits);
+        if(!result.bestMove.isValid())
         {
             break;
         }
-        Move mv = board.legalMoves[rand() % board.legalMoves.size()];
-        board.doMove(mv);
-        auto end  = chrono::steady_clock::now();  
 
+        board.doMove(result.bestMove);
         std::string output = "";
-        board.stringifyMove(mv,output);
+        board.stringifyMove(result.bestMove,output);
 
         board.print();
         
-        cout <<" \nComputer played in " << chrono::duration_cast<chrono::microseconds>(end - start).count()/1000.0 << "ms: " << output;
+        cout <<" \nComputer played in " << result.ms << "ms (depth " << result.depth << ", " << result.nodes << " nodes): " << output;
         cout << ". Your Turn:\n";
         #pragma endregion
     }
@@ -16,51 +16,200 @@
  * along with this program.  If not, see <http://www.gnu.org/licenses/>.
  */
 
+#ifndef MOVE_H
+#define MOVE_H
+
 /**
  * MARKER Includes
  */
 #pragma region 
-#include <vector>
+#include <cstddef>
 #include "bitutils.hpp"
 #pragma endregion
 
 /**
- * Move information holder
+ * MARKER Move flags (4 bits)
+ */
+#pragma region 
+const U8 MOVE_QUIET = 0;
+const U8 MOVE_DOUBLE_PAWN = 1;
+const U8 MOVE_KING_SIDE_CASTLING = 2;
+const U8 MOVE_QUEEN_SIDE_CASTLING = 3;
+const U8 MOVE_CAPTURE = 4; //Capture bit
+const U8 MOVE_EN_PASSANT = 5;
+const U8 MOVE_PROMOTION = 8; //Promotion bit, low 2 bits hold the promotion index
+const U8 MOVE_PROMOTION_CAPTURE = MOVE_PROMOTION | MOVE_CAPTURE;
+#pragma endregion
+
+/**
+ * MARKER Move information holder (16 bits)
+ * 
+ * Bits 0-5: from, 6-11: to, 12-15: flags
+ * Moving and captured piece types are read from the board/undo state
  */
 class Move
 {
 public:
-    U8 from; //From position
-    U8 to; //To position
-    U8 piecetype; //Moving piece type
-    U8 flag; //Move flags
-    U8 capturedpiecetype; //Captured piece type
-    U8 promotionpiecetype; //Promoted piece type
+    U16 data;
 
     Move() //NULL
     {
-        this->flag = 0;
+        this->data = 0;
+    }
+
+    Move(int from, int to, U8 flag)
+    {
+        this->data = (U16)(from | (to << 6) | (flag << 12));
+    }
+
+    //From position
+    inline U8 from() const
+    {
+        return data & 63;
+    }
+
+    //To position
+    inline U8 to() const
+    {
+        return (data >> 6) & 63;
+    }
+
+    //Move flags
+    inline U8 flag() const
+    {
+        return data >> 12;
+    }
+
+    inline bool isCapture() const
+    {
+        return (data >> 12) & MOVE_CAPTURE;
     }
 
-    Move(int from, int to, U8 piecetype, U8 flag)
+    inline bool isPromotion() const
     {
-        this->from = from;
-        this->to = to;
-        this->piecetype = piecetype;
-        this->flag = flag;
-        this->promotionpiecetype = 255;
+        return (data >> 12) & MOVE_PROMOTION;
+    }
+
+    inline bool isEnPassant() const
+    {
+        return flag() == MOVE_EN_PASSANT;
+    }
+
+    inline bool isDoublePawn() const
+    {
+        return flag() == MOVE_DOUBLE_PAWN;
+    }
+
+    inline bool isKingSideCastling() const
+    {
+        return flag() == MOVE_KING_SIDE_CASTLING;
+    }
+
+    inline bool isQueenSideCastling() const
+    {
+        return flag() == MOVE_QUEEN_SIDE_CASTLING;
+    }
+
+    //Promotion index (0-3, game specific piece mapping)
+    inline U8 promotion() const
+    {
+        return (data >> 12) & 3;
     }
 
     //Check if move is valid or NULL
-    bool isValid()
+    inline bool isValid() const
+    {
+        return data != 0;
+    }
+
+    inline bool operator==(const Move &move) const
+    {
+        return data == move.data;
+    }
+
+    inline bool operator!=(const Move &move) const
     {
-        return flag > 0;
+        return data != move.data;
     }
 };
 
 /**
- * MARKER Variable types
+ * MARKER Generation types (Staged generation)
+ */
+#pragma region
+const U8 GEN_CAPTURES = 1; //Captures, en passant and promotions
+const U8 GEN_QUIETS = 2; //Everything else (Pushes, castling and quiet piece moves)
+const U8 GEN_ALL = 3;
+#pragma endregion
+
+/**
+ * MARKER Move list
+ * 
+ * Fixed capacity list with inline storage, generators write into it without touching the heap
  */
 #pragma region 
-typedef std::vector<Move> MoveList;
-#pragma endregion
\ No newline at end of file
+const int MAX_MOVES = 256; //Upper bound of legal moves in a chess position (218)
+
+class MoveList
+{
+public:
+    Move moves[MAX_MOVES];
+    int count;
+
+    MoveList()
+    {
+        count = 0;
+    }
+
+    inline void push_back(const Move &move)
+    {
+        moves[count++] = move;
+    }
+
+    inline void clear()
+    {
+        count = 0;
+    }
+
+    inline size_t size() const
+    {
+        return count;
+    }
+
+    inline bool empty() const
+    {
+        return count == 0;
+    }
+
+    inline Move &operator[](size_t index)
+    {
+        return moves[index];
+    }
+
+    inline const Move &operator[](size_t index) const
+    {
+        return moves[index];
+    }
+
+    inline Move *begin()
+    {
+        return moves;
+    }
+
+    inline Move *end()
+    {
+        return moves + count;
+    }
+
+    inline const Move *begin() const
+    {
+        return moves;
+    }
+
+    inline const Move *end() const
+    {
+        return moves + count;
+    }
+};
+#pragma endregion
+#endif
\ No newline at end of file
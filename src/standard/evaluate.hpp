@@ -0,0 +1,166 @@
+/**
+ * 2aCE (Árnilsen's Adaptable Chess Engine)
+ * Copyright (C) 2021 Árnilsen Arthur Castilho Lopes
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STANDARD_EVALUATE_H
+#define STANDARD_EVALUATE_H
+
+/**
+ * MARKER Includes
+ */
+#pragma region
+#include "standard.hpp"
+#pragma endregion
+
+/**
+ * MARKER Piece-square tables (Standard 8x8)
+ * 
+ * Written from white's view with rank 8 on the first row, white squares are read at pos ^ 56.
+ * Indexed by piece type (Pawn, King, Queen, Bishop, Rook, Knight), the king has a middlegame and an endgame table
+ */
+#pragma region
+const int STANDARD_PST[6][64] = {
+    //Pawn
+    {
+          0,  0,  0,  0,  0,  0,  0,  0,
+         50, 50, 50, 50, 50, 50, 50, 50,
+         10, 10, 20, 30, 30, 20, 10, 10,
+          5,  5, 10, 25, 25, 10,  5,  5,
+          0,  0,  0, 20, 20,  0,  0,  0,
+          5, -5,-10,  0,  0,-10, -5,  5,
+          5, 10, 10,-20,-20, 10, 10,  5,
+          0,  0,  0,  0,  0,  0,  0,  0
+    },
+    //King (Middlegame)
+    {
+        -30,-40,-40,-50,-50,-40,-40,-30,
+        -30,-40,-40,-50,-50,-40,-40,-30,
+        -30,-40,-40,-50,-50,-40,-40,-30,
+        -30,-40,-40,-50,-50,-40,-40,-30,
+        -20,-30,-30,-40,-40,-30,-30,-20,
+        -10,-20,-20,-20,-20,-20,-20,-10,
+         20, 20,  0,  0,  0,  0, 20, 20,
+         20, 30, 10,  0,  0, 10, 30, 20
+    },
+    //Queen
+    {
+        -20,-10,-10, -5, -5,-10,-10,-20,
+        -10,  0,  0,  0,  0,  0,  0,-10,
+        -10,  0,  5,  5,  5,  5,  0,-10,
+         -5,  0,  5,  5,  5,  5,  0, -5,
+          0,  0,  5,  5,  5,  5,  0, -5,
+        -10,  5,  5,  5,  5,  5,  0,-10,
+        -10,  0,  5,  0,  0,  0,  0,-10,
+        -20,-10,-10, -5, -5,-10,-10,-20
+    },
+    //Bishop
+    {
+        -20,-10,-10,-10,-10,-10,-10,-20,
+        -10,  0,  0,  0,  0,  0,  0,-10,
+        -10,  0,  5, 10, 10,  5,  0,-10,
+        -10,  5,  5, 10, 10,  5,  5,-10,
+        -10,  0, 10, 10, 10, 10,  0,-10,
+        -10, 10, 10, 10, 10, 10, 10,-10,
+        -10,  5,  0,  0,  0,  0,  5,-10,
+        -20,-10,-10,-10,-10,-10,-10,-20
+    },
+    //Rook
+    {
+          0,  0,  0,  0,  0,  0,  0,  0,
+          5, 10, 10, 10, 10, 10, 10,  5,
+         -5,  0,  0,  0,  0,  0,  0, -5,
+         -5,  0,  0,  0,  0,  0,  0, -5,
+         -5,  0,  0,  0,  0,  0,  0, -5,
+         -5,  0,  0,  0,  0,  0,  0, -5,
+         -5,  0,  0,  0,  0,  0,  0, -5,
+          0,  0,  0,  5,  5,  0,  0,  0
+    },
+    //Knight
+    {
+        -50,-40,-30,-30,-30,-30,-40,-50,
+        -40,-20,  0,  0,  0,  0,-20,-40,
+        -30,  0, 10, 15, 15, 10,  0,-30,
+        -30,  5, 15, 20, 20, 15,  5,-30,
+        -30,  0, 15, 20, 20, 15,  0,-30,
+        -30,  5, 10, 15, 15, 10,  5,-30,
+        -40,-20,  0,  5,  5,  0,-20,-40,
+        -50,-40,-30,-30,-30,-30,-40,-50
+    }
+};
+
+const int STANDARD_PST_KING_END[64] = {
+    -50,-40,-30,-20,-20,-30,-40,-50,
+    -30,-20,-10,  0,  0,-10,-20,-30,
+    -30,-10, 20, 30, 30, 20,-10,-30,
+    -30,-10, 30, 40, 40, 30,-10,-30,
+    -30,-10, 30, 40, 40, 30,-10,-30,
+    -30,-10, 20, 30, 30, 20,-10,-30,
+    -30,-30,  0,  0,  0,  0,-30,-30,
+    -50,-30,-30,-30,-30,-30,-30,-50
+};
+
+//Game phase weight of each piece type (24 with all pieces on the board)
+const int STANDARD_PHASE[6] = {0, 0, 4, 1, 2, 1};
+const int STANDARD_PHASE_MAX = 24;
+#pragma endregion
+
+/**
+ * MARKER Evaluation
+ * 
+ * Material and piece-square tables, the king table is blended by game phase.
+ * Score in centipawns from the side to move's view
+ */
+#pragma region
+int evaluate(const StandardBoard &board)
+{
+    int score[2] = {0, 0};
+    int kingMiddle[2] = {0, 0};
+    int kingEnd[2] = {0, 0};
+    int phase = 0;
+
+    for(int player = 0; player < 2; player ++)
+    {
+        int flip = player == STANDARD_PLAYER_WHITE ? 56 : 0;
+
+        for(int type = 0; type < 6; type ++)
+        {
+            for(int pos : board._pieces[player][type])
+            {
+                if(type == STANDARD_PT_KING)
+                {
+                    kingMiddle[player] += STANDARD_PST[type][pos ^ flip];
+                    kingEnd[player] += STANDARD_PST_KING_END[pos ^ flip];
+                    continue;
+                }
+
+                score[player] += STANDARD_PIECE_VALUES[type] + STANDARD_PST[type][pos ^ flip];
+                phase += STANDARD_PHASE[type];
+            }
+        }
+    }
+
+    if(phase > STANDARD_PHASE_MAX)
+        phase = STANDARD_PHASE_MAX;
+
+    for(int player = 0; player < 2; player ++)
+        score[player] += (kingMiddle[player] * phase + kingEnd[player] * (STANDARD_PHASE_MAX - phase)) / STANDARD_PHASE_MAX;
+
+    int us = board.currentPlayer;
+    return score[us] - score[us ^ 1];
+}
+#pragma endregion
+#endif
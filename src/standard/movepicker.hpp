@@ -0,0 +1,348 @@
+/**
+ * 2aCE (Árnilsen's Adaptable Chess Engine)
+ * Copyright (C) 2021 Árnilsen Arthur Castilho Lopes
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MOVEPICKER_H
+#define MOVEPICKER_H
+
+/**
+ * MARKER Includes
+ */
+#pragma region
+#include <cstdlib>
+#include "standard.hpp"
+#pragma endregion
+
+/**
+ * MARKER Quiet move history
+ * 
+ * Butterfly history (Side, from, to), countermoves (Reply to the previous piece and destination)
+ * and continuation history (Previous piece and destination, piece and destination).
+ * Scores move toward +-STANDARD_HISTORY_MAX with every update, so old results fade out
+ */
+#pragma region
+const int STANDARD_HISTORY_MAX = 16384;
+
+struct StandardHistory
+{
+    int butterfly[2][64][64];
+    Move counterMoves[6][64];
+    int continuation[6][64][6][64];
+
+    StandardHistory()
+    {
+        clear();
+    }
+
+    void clear()
+    {
+        memset(butterfly, 0, sizeof(butterfly));
+        memset(continuation, 0, sizeof(continuation));
+
+        for(int i = 0; i < 6; i ++)
+            for(int j = 0; j < 64; j ++)
+                counterMoves[i][j] = Move();
+    }
+
+    //Halve the butterfly and continuation scores between searches
+    void age()
+    {
+        for(int i = 0; i < 2; i ++)
+            for(int j = 0; j < 64; j ++)
+                for(int k = 0; k < 64; k ++)
+                    butterfly[i][j][k] /= 2;
+
+        for(int i = 0; i < 6; i ++)
+            for(int j = 0; j < 64; j ++)
+                for(int k = 0; k < 6; k ++)
+                    for(int l = 0; l < 64; l ++)
+                        continuation[i][j][k][l] /= 2;
+    }
+
+    static void _gravity(int &entry, int bonus)
+    {
+        entry += bonus - entry * std::abs(bonus) / STANDARD_HISTORY_MAX;
+    }
+
+    //Bonus for the move that cut off, malus (Negative bonus) for the quiets tried before it
+    void update(U8 player, Move move, U8 piece, int previousPiece, int previousTo, int bonus)
+    {
+        _gravity(butterfly[player][move.from()][move.to()], bonus);
+
+        if(previousPiece >= 0)
+            _gravity(continuation[previousPiece][previousTo][piece][move.to()], bonus);
+    }
+};
+#pragma endregion
+
+/**
+ * MARKER Picker stages
+ */
+#pragma region
+enum PickerStage
+{
+    STAGE_HASH = 0,
+    STAGE_CAPTURES_INIT = 1,
+    STAGE_CAPTURES = 2,
+    STAGE_KILLERS = 3,
+    STAGE_QUIETS_INIT = 4,
+    STAGE_QUIETS = 5,
+    STAGE_BAD_CAPTURES = 6,
+    STAGE_EVASIONS_INIT = 7,
+    STAGE_EVASIONS = 8,
+    STAGE_DONE = 9
+};
+#pragma endregion
+
+/**
+ * MARKER Standard move picker
+ * 
+ * Hands out the legal moves of a position one at a time, best guesses first:
+ * hash move, winning captures (MVV-LVA), killers, countermove, the quiet moves
+ * by history and last the captures that lose material (SEE). Moves of a stage are
+ * picked by partial selection sort, so a cut off after a few moves never sorts the rest.
+ * Each stage is generated only when the previous one runs out, so a node
+ * that cuts off on the hash move or a capture never generates its quiets.
+ * In check, the hash move is followed by the (few) evasions, captures first.
+ * With GEN_CAPTURES (Quiescence) the picker stops after the winning captures unless in check.
+ * 
+ * The board may be changed between calls as long as it is restored (doMove/undoMove).
+ */
+#pragma region
+class StandardMovePicker
+{
+public:
+    /**
+     * MARKER Fields
+     */
+    #pragma region
+    StandardBoard &board;
+    int stage;
+    bool inCheck;
+    U8 genType;
+
+    //Special moves (Killers and countermove are tried in the killers stage)
+    Move hashMove;
+    Move killers[3];
+    int killerIndex;
+
+    //Quiet move ordering (Optional)
+    const StandardHistory *history;
+    const int *continuation; //Continuation history row of the previous move
+
+    //Current stage moves (Losing captures are kept at the front, quiets are generated after them)
+    MoveList moves;
+    int scores[MAX_MOVES];
+    size_t index;
+    size_t badCount;
+    size_t badIndex;
+    #pragma endregion
+
+    /**
+     * MARKER Constructor
+     */
+    StandardMovePicker(StandardBoard &board, Move hashMove = Move(), Move killer1 = Move(), Move killer2 = Move(), U8 genType = GEN_ALL,
+        const StandardHistory *history = nullptr, Move counterMove = Move(), const int *continuation = nullptr) : board(board)
+    {
+        this->genType = genType;
+        this->history = history;
+        this->continuation = continuation;
+        this->hashMove = hashMove;
+        this->killers[0] = killer1;
+        this->killers[1] = killer2;
+        this->killers[2] = counterMove != killer1 && counterMove != killer2 ? counterMove : Move();
+        this->killerIndex = 0;
+        this->index = 0;
+        this->badCount = 0;
+        this->badIndex = 0;
+        this->stage = STAGE_HASH;
+        this->inCheck = board.playerIsInCheck(board.currentPlayer);
+    }
+
+    /**
+     * MARKER Picking
+     */
+    #pragma region
+    //Next move to try, invalid Move when all moves were given
+    Move next()
+    {
+        switch (stage)
+        {
+            case STAGE_HASH:
+                stage = inCheck ? STAGE_EVASIONS_INIT : STAGE_CAPTURES_INIT;
+                if(genType == GEN_CAPTURES && !inCheck && !hashMove.isCapture() && !hashMove.isPromotion())
+                    hashMove = Move();
+                if(board.isLegalMove(hashMove))
+                    return hashMove;
+                return next();
+
+            case STAGE_CAPTURES_INIT:
+                moves.clear();
+                board.genCaptures(moves);
+                _scoreCaptures();
+                index = 0;
+                stage = STAGE_CAPTURES;
+                [[fallthrough]];
+
+            case STAGE_CAPTURES:
+                while (index < moves.size())
+                {
+                    Move move = _pickBest();
+                    if(move == hashMove)
+                        continue;
+
+                    //Slot already handed out, badCount never passes index
+                    if(!board.seeGE(move,0))
+                    {
+                        moves[badCount++] = move;
+                        continue;
+                    }
+
+                    return move;
+                }
+                if(genType == GEN_CAPTURES)
+                {
+                    stage = STAGE_DONE;
+                    return Move();
+                }
+                stage = STAGE_KILLERS;
+                [[fallthrough]];
+
+            case STAGE_KILLERS:
+                while (killerIndex < 3)
+                {
+                    Move killer = killers[killerIndex++];
+
+                    //Killers are quiet moves from a sibling node, they may not be legal here
+                    if(killer != hashMove && !killer.isCapture() && !killer.isPromotion() && board.isLegalMove(killer))
+                        return killer;
+                }
+                stage = STAGE_QUIETS_INIT;
+                [[fallthrough]];
+
+            case STAGE_QUIETS_INIT:
+                moves.count = badCount;
+                board.genMoves(moves,GEN_QUIETS);
+                index = badCount;
+                _scoreQuiets();
+                stage = STAGE_QUIETS;
+                [[fallthrough]];
+
+            case STAGE_QUIETS:
+                while (index < moves.size())
+                {
+                    Move move = history ? _pickBest() : moves[index++];
+                    if(move != hashMove && move != killers[0] && move != killers[1] && move != killers[2])
+                        return move;
+                }
+                stage = STAGE_BAD_CAPTURES;
+                [[fallthrough]];
+
+            case STAGE_BAD_CAPTURES:
+                if(badIndex < badCount)
+                    return moves[badIndex++];
+                stage = STAGE_DONE;
+                return Move();
+
+            case STAGE_EVASIONS_INIT:
+                moves.clear();
+                board.genEvasions(moves);
+                _scoreCaptures();
+                index = 0;
+                stage = STAGE_EVASIONS;
+                [[fallthrough]];
+
+            case STAGE_EVASIONS:
+                while (index < moves.size())
+                {
+                    Move move = _pickBest();
+                    if(move != hashMove)
+                        return move;
+                }
+                stage = STAGE_DONE;
+                [[fallthrough]];
+
+            default:
+                return Move();
+        }
+    }
+
+    //Most valuable victim, least valuable attacker (Promotions count as winning the promoted piece, quiet moves go last)
+    void _scoreCaptures()
+    {
+        U8 other = board.currentPlayer == 0 ? 1 : 0;
+
+        for (size_t i = 0; i < moves.size(); i ++)
+        {
+            Move move = moves[i];
+            int victim = move.isEnPassant() ? STANDARD_PT_PAWN : board.getPiece(other,move.to());
+            int attacker = board.getPiece(board.currentPlayer,move.from());
+
+            int score = 0;
+            if(victim != 255)
+                score += STANDARD_PIECE_VALUES[victim] * 16;
+            if(move.isPromotion())
+                score += (STANDARD_PIECE_VALUES[STANDARD_PROMOTIONS[move.promotion()]] - STANDARD_PIECE_VALUES[STANDARD_PT_PAWN]) * 16;
+
+            scores[i] = score - (attacker == STANDARD_PT_KING ? 1000 : STANDARD_PIECE_VALUES[attacker] / 10);
+        }
+    }
+
+    //Butterfly plus continuation history (Generation order without history)
+    void _scoreQuiets()
+    {
+        if(!history)
+            return;
+
+        U8 player = board.currentPlayer;
+
+        for (size_t i = index; i < moves.size(); i ++)
+        {
+            Move move = moves[i];
+            int score = history->butterfly[player][move.from()][move.to()];
+
+            if(continuation)
+                score += continuation[board.pieceTypeOn(move.from()) * 64 + move.to()];
+
+            scores[i] = score;
+        }
+    }
+
+    //Swap the best scored move of the remaining ones to the front and return it
+    Move _pickBest()
+    {
+        size_t best = index;
+
+        for (size_t i = index + 1; i < moves.size(); i ++)
+            if(scores[i] > scores[best])
+                best = i;
+
+        Move move = moves[best];
+        int score = scores[best];
+
+        moves[best] = moves[index];
+        scores[best] = scores[index];
+        moves[index] = move;
+        scores[index] = score;
+
+        index ++;
+        return move;
+    }
+    #pragma endregion
+};
+#pragma endregion
+#endif
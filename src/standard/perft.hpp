@@ -0,0 +1,581 @@
+/**
+ * 2aCE (Árnilsen's Adaptable Chess Engine)
+ * Copyright (C) 2021 Árnilsen Arthur Castilho Lopes
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STANDARD_PERFT_H
+#define STANDARD_PERFT_H
+
+/**
+ * MARKER Includes
+ */
+#pragma region
+#include <iostream>
+#include <chrono>
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "standard.hpp"
+#pragma endregion
+
+/**
+ * MARKER Perft suite (Standard 8x8)
+ * 
+ * Well known positions with their verified node counts
+ */
+#pragma region
+struct StandardPerftPosition
+{
+    const char *name;
+    const char *fen;
+    int depth;
+    U64 nodes;
+};
+
+const StandardPerftPosition STANDARD_PERFT_SUITE[] = {
+    {"Start position", "rnbqkbnr/pppppppp/8/8/8/8/PPPPPPPP/RNBQKBNR w KQkq - 0 1", 5, 4865609ULL},
+    {"Kiwipete", "r3k2r/p1ppqpb1/bn2pnp1/3PN3/1p2P3/2N2Q1p/PPPBBPPP/R3K2R w KQkq - 0 1", 4, 4085603ULL},
+    {"Rook endgame", "8/2p5/3p4/KP5r/1R3p1k/8/4P1P1/8 w - - 0 1", 6, 11030083ULL},
+    {"Promotions", "r3k2r/Pppp1ppp/1b3nbN/nP6/BBP1P3/q4N2/Pp1P2PP/R2Q1RK1 w kq - 0 1", 5, 15833292ULL},
+    {"Promotions (Mirrored)", "r2q1rk1/pP1p2pp/Q4n2/bbp1p3/Np6/1B3NBn/pPPP1PPP/R3K2R b KQ - 0 1", 5, 15833292ULL},
+    {"Discovered checks", "rnbq1k1r/pp1Pbppp/2p5/8/2B5/8/PPP1NnPP/RNBQK2R w KQ - 1 8", 4, 2103487ULL},
+    {"Middlegame", "r4rk1/1pp1qppp/p1np1n2/2b1p1B1/2B1P1b1/P1NP1N2/1PP1QPPP/R4RK1 w - - 0 10", 4, 3894594ULL},
+    {"En passant without king", "4k3/8/8/3pP3/8/8/8/8 w - d6 0 1", 5, 84ULL},
+};
+
+const int STANDARD_PERFT_SUITE_SIZE = sizeof(STANDARD_PERFT_SUITE) / sizeof(STANDARD_PERFT_SUITE[0]);
+#pragma endregion
+
+/**
+ * MARKER SEE suite (Standard 8x8)
+ * 
+ * Exchanges with a known outcome, both see() and seeGE() around the value are checked
+ */
+#pragma region
+struct StandardSeePosition
+{
+    const char *name;
+    const char *fen;
+    const char *move;
+    int value;
+};
+
+const StandardSeePosition STANDARD_SEE_SUITE[] = {
+    {"Undefended pawn", "1k1r4/1pp4p/p7/4p3/8/P5P1/1PP4P/2K1R3 w - - 0 1", "Rxe5", 100},
+    {"Knight into battery", "1k1r3q/1ppn3p/p4b2/4p3/8/P2N2P1/1PP1R1BP/2K1Q3 w - - 0 1", "Nxe5", -220},
+    {"Queen behind rook", "3r2k1/8/8/3p4/8/8/3R4/3Q2K1 w - - 0 1", "Rxd5", 100},
+    {"Queen behind rook (Pawn defended)", "3r2k1/8/2p5/3p4/8/8/3R4/3Q2K1 w - - 0 1", "Rxd5", -400},
+    {"Queen behind rook (Black)", "3q2k1/3r4/8/8/3P4/8/8/3R2K1 b - - 0 1", "Rxd4", 100},
+    {"X-ray queen behind recapturing rook", "3r2k1/8/5n2/3p4/8/2N5/3R4/3Q2K1 w - - 0 1", "Nxd5", 100},
+};
+
+const int STANDARD_SEE_SUITE_SIZE = sizeof(STANDARD_SEE_SUITE) / sizeof(STANDARD_SEE_SUITE[0]);
+#pragma endregion
+
+/**
+ * MARKER Perft cache
+ * 
+ * Node counts by (Zobrist key, depth), shared by all threads without locks.
+ * Data holds count << 8 | depth and the stored key is key ^ data, a torn write reads as a miss
+ */
+#pragma region
+const int STANDARD_PERFT_CACHE_CLUSTER = 4; //Entries per 64 byte cluster
+const int STANDARD_PERFT_CACHE_MIN_DEPTH = 2; //Depth 1 is bulk counted, cheaper than a probe
+
+struct alignas(64) StandardPerftCacheCluster
+{
+    std::atomic<U64> check[STANDARD_PERFT_CACHE_CLUSTER];
+    std::atomic<U64> data[STANDARD_PERFT_CACHE_CLUSTER];
+};
+
+class StandardPerftCache
+{
+public:
+    StandardPerftCacheCluster *clusters;
+    size_t clusterCount;
+
+    StandardPerftCache(size_t mb)
+    {
+        clusterCount = 1;
+        while(clusterCount * 2 * sizeof(StandardPerftCacheCluster) <= mb * 1024 * 1024)
+            clusterCount *= 2;
+
+        clusters = new StandardPerftCacheCluster[clusterCount];
+        clear();
+    }
+
+    ~StandardPerftCache()
+    {
+        delete[] clusters;
+    }
+
+    StandardPerftCache(const StandardPerftCache &) = delete;
+    StandardPerftCache &operator=(const StandardPerftCache &) = delete;
+
+    void clear()
+    {
+        for(size_t i = 0; i < clusterCount; i ++)
+            for(int j = 0; j < STANDARD_PERFT_CACHE_CLUSTER; j ++)
+            {
+                clusters[i].check[j].store(0, std::memory_order_relaxed);
+                clusters[i].data[j].store(0, std::memory_order_relaxed);
+            }
+    }
+
+    bool probe(U64 key, int depth, U64 &nodes) const
+    {
+        StandardPerftCacheCluster &c = clusters[key & (clusterCount - 1)];
+
+        for(int i = 0; i < STANDARD_PERFT_CACHE_CLUSTER; i ++)
+        {
+            U64 data = c.data[i].load(std::memory_order_relaxed);
+            U64 check = c.check[i].load(std::memory_order_relaxed);
+
+            if((data & 255) == (U64)depth && (check ^ data) == key)
+            {
+                nodes = data >> 8;
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    //Replaces the shallowest entry (Deeper counts save more work)
+    void store(U64 key, int depth, U64 nodes)
+    {
+        StandardPerftCacheCluster &c = clusters[key & (clusterCount - 1)];
+        int victim = 0;
+        U64 victimDepth = 256;
+
+        for(int i = 0; i < STANDARD_PERFT_CACHE_CLUSTER; i ++)
+        {
+            U64 entryDepth = c.data[i].load(std::memory_order_relaxed) & 255;
+            if(entryDepth < victimDepth)
+            {
+                victimDepth = entryDepth;
+                victim = i;
+            }
+        }
+
+        U64 data = (nodes << 8) | (U64)depth;
+        c.data[victim].store(data, std::memory_order_relaxed);
+        c.check[victim].store(key ^ data, std::memory_order_relaxed);
+    }
+};
+#pragma endregion
+
+/**
+ * MARKER Perft
+ * 
+ * Leaf nodes of the legal move tree, the last ply is counted from the move list size (Bulk counting)
+ */
+#pragma region
+U64 perft(StandardBoard &board, int depth)
+{
+    if(depth <= 0)
+        return 1;
+
+    MoveList moves;
+    board.genMoves(moves, GEN_ALL);
+
+    if(depth == 1)
+        return moves.size();
+
+    U64 nodes = 0;
+    for(Move move : moves)
+    {
+        board.doMove(move);
+        nodes += perft(board, depth - 1);
+        board.undoMove(move);
+    }
+
+    return nodes;
+}
+
+//Perft reusing the counts of transposed subtrees
+U64 perftHashed(StandardBoard &board, int depth, StandardPerftCache &cache)
+{
+    if(depth < STANDARD_PERFT_CACHE_MIN_DEPTH)
+        return perft(board, depth);
+
+    U64 key = board.state().key;
+    U64 nodes = 0;
+    if(cache.probe(key, depth, nodes))
+        return nodes;
+
+    MoveList moves;
+    board.genMoves(moves, GEN_ALL);
+
+    for(Move move : moves)
+    {
+        board.doMove(move);
+        nodes += perftHashed(board, depth - 1, cache);
+        board.undoMove(move);
+    }
+
+    cache.store(key, depth, nodes);
+    return nodes;
+}
+
+inline U64 _perft(StandardBoard &board, int depth, StandardPerftCache *cache)
+{
+    return cache ? perftHashed(board, depth, *cache) : perft(board, depth);
+}
+
+//Perft split by root move
+U64 divide(StandardBoard &board, int depth, std::ostream &out = std::cout, StandardPerftCache *cache = nullptr)
+{
+    MoveList moves;
+    board.genMoves(moves, GEN_ALL);
+
+    U64 nodes = 0;
+    for(Move move : moves)
+    {
+        //Moves are named after being made
+        std::string name;
+        board.doMove(move);
+        board.stringifyMove(move, name);
+        U64 count = _perft(board, depth - 1, cache);
+        board.undoMove(move);
+
+        out << name << ": " << count << "\n";
+
+        nodes += count;
+    }
+
+    out << "\nMoves: " << moves.size() << "\nNodes: " << nodes << "\n";
+    return nodes;
+}
+#pragma endregion
+
+/**
+ * MARKER Parallel perft
+ * 
+ * Subtrees are split into tasks down to STANDARD_PERFT_SPLIT_DEPTH and kept on per worker deques.
+ * A worker takes its newest task (Depth first, small tree) and idle workers steal the oldest one
+ * from another worker (Biggest subtree left), so the load balances itself while counting
+ */
+#pragma region
+const int STANDARD_PERFT_SPLIT_DEPTH = 3; //Tasks at or below this depth are counted by a single thread
+const int STANDARD_PERFT_MAX_PATH = 16;
+
+//Subtree given by the moves from the root position
+struct StandardPerftTask
+{
+    Move path[STANDARD_PERFT_MAX_PATH];
+    int length;
+    int depth;
+    int root; //Root move index (Divide)
+};
+
+class StandardParallelPerft
+{
+public:
+    struct Worker
+    {
+        StandardBoard board; //Own copy, kept at the root position between tasks
+        std::deque<StandardPerftTask> tasks;
+        std::mutex lock;
+    };
+
+    /**
+     * MARKER Fields
+     */
+    #pragma region
+    std::vector<std::unique_ptr<Worker>> workers;
+    std::vector<std::atomic<U64>> rootNodes;
+    std::atomic<long> pending;
+    MoveList rootMoves;
+    StandardPerftCache *cache; //Optional, shared by all workers
+    #pragma endregion
+
+    /**
+     * MARKER Constructors
+     */
+    #pragma region
+    StandardParallelPerft(const StandardBoard &board, int threads, StandardPerftCache *cache = nullptr)
+    {
+        this->cache = cache;
+
+        if(threads < 1)
+            threads = 1;
+
+        for(int i = 0; i < threads; i ++)
+        {
+            workers.push_back(std::unique_ptr<Worker>(new Worker()));
+            workers[i]->board = board;
+        }
+
+        pending = 0;
+    }
+    #pragma endregion
+
+    /**
+     * MARKER Run
+     */
+    #pragma region
+    //Total leaf nodes, rootNodes holds the count of each root move
+    U64 run(int depth)
+    {
+        StandardBoard &board = workers[0]->board;
+        board.genMoves(rootMoves, GEN_ALL);
+        rootNodes = std::vector<std::atomic<U64>>(rootMoves.size());
+
+        if(depth <= 1)
+        {
+            for(size_t i = 0; i < rootMoves.size(); i ++)
+                rootNodes[i] = depth == 1 ? 1 : 0;
+            return depth == 1 ? rootMoves.size() : 1;
+        }
+
+        //Root moves dealt to the workers
+        for(size_t i = 0; i < rootMoves.size(); i ++)
+        {
+            StandardPerftTask task;
+            task.path[0] = rootMoves[i];
+            task.length = 1;
+            task.depth = depth - 1;
+            task.root = (int)i;
+
+            _push(*workers[i % workers.size()], task);
+        }
+
+        std::vector<std::thread> threads;
+        for(size_t i = 1; i < workers.size(); i ++)
+            threads.push_back(std::thread(&StandardParallelPerft::_work, this, (int)i));
+
+        _work(0);
+
+        for(std::thread &thread : threads)
+            thread.join();
+
+        U64 nodes = 0;
+        for(size_t i = 0; i < rootNodes.size(); i ++)
+            nodes += rootNodes[i];
+
+        return nodes;
+    }
+    #pragma endregion
+
+    /**
+     * MARKER Workers
+     */
+    #pragma region
+    void _push(Worker &worker, const StandardPerftTask &task)
+    {
+        pending ++;
+
+        std::lock_guard<std::mutex> guard(worker.lock);
+        worker.tasks.push_back(task);
+    }
+
+    bool _pop(Worker &worker, StandardPerftTask &task)
+    {
+        std::lock_guard<std::mutex> guard(worker.lock);
+        if(worker.tasks.empty())
+            return false;
+
+        task = worker.tasks.back();
+        worker.tasks.pop_back();
+        return true;
+    }
+
+    bool _steal(int id, StandardPerftTask &task)
+    {
+        for(size_t i = 1; i < workers.size(); i ++)
+        {
+            Worker &victim = *workers[(id + i) % workers.size()];
+
+            std::lock_guard<std::mutex> guard(victim.lock);
+            if(!victim.tasks.empty())
+            {
+                task = victim.tasks.front();
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void _work(int id)
+    {
+        Worker &worker = *workers[id];
+        StandardPerftTask task;
+
+        //Pending only reaches 0 after the last task finished (Children are pushed before the parent ends)
+        while(pending > 0)
+        {
+            if(_pop(worker, task) || _steal(id, task))
+                _runTask(worker, task);
+            else
+                std::this_thread::yield();
+        }
+    }
+
+    void _runTask(Worker &worker, const StandardPerftTask &task)
+    {
+        StandardBoard &board = worker.board;
+
+        for(int i = 0; i < task.length; i ++)
+            board.doMove(task.path[i]);
+
+        if(task.depth > STANDARD_PERFT_SPLIT_DEPTH && task.length < STANDARD_PERFT_MAX_PATH)
+        {
+            MoveList moves;
+            board.genMoves(moves, GEN_ALL);
+
+            StandardPerftTask child = task;
+            child.length = task.length + 1;
+            child.depth = task.depth - 1;
+
+            for(Move move : moves)
+            {
+                child.path[task.length] = move;
+                _push(worker, child);
+            }
+        }
+        else
+            rootNodes[task.root] += _perft(board, task.depth, cache);
+
+        for(int i = task.length - 1; i >= 0; i --)
+            board.undoMove(task.path[i]);
+
+        pending --;
+    }
+    #pragma endregion
+};
+
+//Perft over the given number of threads
+U64 parallelPerft(StandardBoard &board, int depth, int threads, StandardPerftCache *cache = nullptr)
+{
+    StandardParallelPerft search(board, threads, cache);
+    return search.run(depth);
+}
+
+//Divide over the given number of threads
+U64 parallelDivide(StandardBoard &board, int depth, int threads, std::ostream &out = std::cout, StandardPerftCache *cache = nullptr)
+{
+    StandardParallelPerft search(board, threads, cache);
+    U64 nodes = search.run(depth);
+
+    for(size_t i = 0; i < search.rootMoves.size(); i ++)
+    {
+        std::string name;
+        board.doMove(search.rootMoves[i]);
+        board.stringifyMove(search.rootMoves[i], name);
+        board.undoMove(search.rootMoves[i]);
+        out << name << ": " << search.rootNodes[i] << "\n";
+    }
+
+    out << "\nMoves: " << search.rootMoves.size() << "\nNodes: " << nodes << "\n";
+    return nodes;
+}
+#pragma endregion
+
+/**
+ * MARKER Benchmark
+ */
+#pragma region
+//Elapsed milliseconds and nodes per second line
+void _printPerftSpeed(U64 nodes, double ms, std::ostream &out)
+{
+    out << nodes << " nodes in " << ms << "ms (" << (ms > 0 ? nodes / ms / 1000.0 : 0) << " Mnps)\n";
+}
+
+//Timed perft of a single position (Parallel for more than one thread, hashed when given a cache)
+U64 runPerft(StandardBoard &board, int depth, bool split = false, int threads = 1, StandardPerftCache *cache = nullptr, std::ostream &out = std::cout)
+{
+    auto start = std::chrono::steady_clock::now();
+    U64 nodes;
+    if(threads > 1)
+        nodes = split ? parallelDivide(board, depth, threads, out, cache) : parallelPerft(board, depth, threads, cache);
+    else
+        nodes = split ? divide(board, depth, out, cache) : _perft(board, depth, cache);
+    auto end = std::chrono::steady_clock::now();
+
+    _printPerftSpeed(nodes, std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0, out);
+    return nodes;
+}
+
+//Run all suite positions, returns false if any count is wrong
+bool runPerftSuite(int threads = 1, StandardPerftCache *cache = nullptr, std::ostream &out = std::cout)
+{
+    StandardBoard board;
+    U64 total = 0;
+    double totalMs = 0;
+    bool passed = true;
+
+    for(int i = 0; i < STANDARD_PERFT_SUITE_SIZE; i ++)
+    {
+        const StandardPerftPosition &position = STANDARD_PERFT_SUITE[i];
+
+        std::string status;
+        board.loadBoard(position.fen, status);
+
+        auto start = std::chrono::steady_clock::now();
+        U64 nodes = threads > 1 ? parallelPerft(board, position.depth, threads, cache) : _perft(board, position.depth, cache);
+        auto end = std::chrono::steady_clock::now();
+        double ms = std::chrono::duration_cast<std::chrono::microseconds>(end - start).count() / 1000.0;
+
+        bool ok = nodes == position.nodes;
+        passed &= ok;
+        total += nodes;
+        totalMs += ms;
+
+        out << (ok ? "[OK]   " : "[FAIL] ") << position.name << " (depth " << position.depth << "): " << nodes;
+        if(!ok)
+            out << ", expected " << position.nodes;
+        out << " | " << ms << "ms\n";
+    }
+
+    out << "\n" << (passed ? "All positions passed. " : "Some positions failed. ");
+    _printPerftSpeed(total, totalMs, out);
+    return passed;
+}
+
+//Run all SEE positions, returns false if any value is wrong
+bool runSeeSuite(std::ostream &out = std::cout)
+{
+    StandardBoard board;
+    bool passed = true;
+
+    for(int i = 0; i < STANDARD_SEE_SUITE_SIZE; i ++)
+    {
+        const StandardSeePosition &position = STANDARD_SEE_SUITE[i];
+
+        std::string status;
+        board.loadBoard(position.fen, status);
+        Move move = board.parseMove(position.move, status);
+
+        int value = move.isValid() ? board.see(move) : 0;
+        bool ok = move.isValid() && value == position.value && board.seeGE(move, position.value) && !board.seeGE(move, position.value + 1);
+        passed &= ok;
+
+        out << (ok ? "[OK]   " : "[FAIL] ") << position.name << " (SEE " << position.move << "): " << value;
+        if(!ok)
+            out << ", expected " << position.value;
+        out << "\n";
+    }
+
+    return passed;
+}
+#pragma endregion
+#endif
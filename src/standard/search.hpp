@@ -0,0 +1,686 @@
+/**
+ * 2aCE (Árnilsen's Adaptable Chess Engine)
+ * Copyright (C) 2021 Árnilsen Arthur Castilho Lopes
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STANDARD_SEARCH_H
+#define STANDARD_SEARCH_H
+
+/**
+ * MARKER Includes
+ */
+#pragma region
+#include <iostream>
+#include <chrono>
+#include <atomic>
+#include <memory>
+#include "standard.hpp"
+#include "movepicker.hpp"
+#include "evaluate.hpp"
+#include "../tt.hpp"
+#pragma endregion
+
+/**
+ * MARKER Search constants
+ */
+#pragma region
+const int SEARCH_MAX_PLY = 128;
+const int SCORE_INFINITE = 32001;
+const int SCORE_MATE = 32000; //Mate at ply p scores SCORE_MATE - p
+const int SCORE_MATE_BOUND = SCORE_MATE - SEARCH_MAX_PLY; //Scores beyond are mates
+const int SCORE_NONE = 32002; //No static eval stored
+const int SEARCH_ASPIRATION_DEPTH = 4; //First depth searched with a window around the last score
+const int SEARCH_ASPIRATION_DELTA = 25;
+const int SEARCH_CHECK_NODES = 2047; //Limits are checked every 2048 nodes
+const int SEARCH_DEFAULT_TIME = 1000; //Computer think time in the play loop (ms)
+const int SEARCH_HISTORY_BONUS_MAX = 1600; //Depth * depth history bonus cap
+const int SEARCH_MAX_QUIETS = 64; //Quiet moves remembered per node for the history malus
+
+//Lazy SMP helpers skip some iterations so threads spread over different depths
+const int SEARCH_SKIP_SIZE[20] = {1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 3, 3, 4, 4, 4, 4, 4, 4, 4, 4};
+const int SEARCH_SKIP_PHASE[20] = {0, 1, 0, 1, 2, 3, 0, 1, 2, 3, 4, 5, 0, 1, 2, 3, 4, 5, 6, 7};
+
+//ABDADA, moves are only deferred from this depth on (Smaller trees are cheaper to search twice)
+const int SEARCH_ABDADA_DEPTH = 3;
+const int SEARCH_ABDADA_SIZE = 32768;
+const int SEARCH_ABDADA_WAYS = 4;
+#pragma endregion
+
+/**
+ * MARKER Searching marks (ABDADA)
+ * 
+ * Moves being searched right now by some thread, as hashes of (position key, move).
+ * Marks are hints, a lost or stale mark only costs a duplicated or delayed subtree
+ */
+#pragma region
+class SearchingMarks
+{
+public:
+    std::atomic<U64> table[SEARCH_ABDADA_SIZE][SEARCH_ABDADA_WAYS];
+
+    SearchingMarks()
+    {
+        clear();
+    }
+
+    void clear()
+    {
+        for(int i = 0; i < SEARCH_ABDADA_SIZE; i ++)
+            for(int j = 0; j < SEARCH_ABDADA_WAYS; j ++)
+                table[i][j].store(0, std::memory_order_relaxed);
+    }
+
+    bool isSearching(U64 moveHash) const
+    {
+        const std::atomic<U64> *slot = table[moveHash & (SEARCH_ABDADA_SIZE - 1)];
+
+        for(int i = 0; i < SEARCH_ABDADA_WAYS; i ++)
+            if(slot[i].load(std::memory_order_relaxed) == moveHash)
+                return true;
+
+        return false;
+    }
+
+    //First free way, the first way when all are taken
+    void start(U64 moveHash)
+    {
+        std::atomic<U64> *slot = table[moveHash & (SEARCH_ABDADA_SIZE - 1)];
+
+        for(int i = 0; i < SEARCH_ABDADA_WAYS; i ++)
+            if(slot[i].load(std::memory_order_relaxed) == 0)
+            {
+                slot[i].store(moveHash, std::memory_order_relaxed);
+                return;
+            }
+
+        slot[0].store(moveHash, std::memory_order_relaxed);
+    }
+
+    void finish(U64 moveHash)
+    {
+        std::atomic<U64> *slot = table[moveHash & (SEARCH_ABDADA_SIZE - 1)];
+
+        for(int i = 0; i < SEARCH_ABDADA_WAYS; i ++)
+            if(slot[i].load(std::memory_order_relaxed) == moveHash)
+            {
+                slot[i].store(0, std::memory_order_relaxed);
+                return;
+            }
+    }
+};
+#pragma endregion
+
+/**
+ * MARKER Limits and result
+ */
+#pragma region
+//Zero means unlimited
+struct SearchLimits
+{
+    int depth = SEARCH_MAX_PLY - 1;
+    U64 nodes = 0;
+    int timeMs = 0;
+};
+
+struct SearchResult
+{
+    Move bestMove;
+    int score = 0;
+    int depth = 0;
+    U64 nodes = 0;
+    double ms = 0;
+    Move pv[SEARCH_MAX_PLY];
+    int pvLength = 0;
+};
+
+//Mate scores are stored relative to the node, not to the root
+inline int scoreToTT(int score, int ply)
+{
+    return score >= SCORE_MATE_BOUND ? score + ply : score <= -SCORE_MATE_BOUND ? score - ply : score;
+}
+
+inline int scoreFromTT(int score, int ply)
+{
+    return score >= SCORE_MATE_BOUND ? score - ply : score <= -SCORE_MATE_BOUND ? score + ply : score;
+}
+#pragma endregion
+
+/**
+ * MARKER Standard search
+ * 
+ * Iterative deepening negamax with principal variation search, aspiration windows,
+ * a triangular PV table and quiescence on captures. The board is restored after every search
+ */
+#pragma region
+class StandardSearch
+{
+public:
+    /**
+     * MARKER Fields
+     */
+    #pragma region
+    StandardBoard &board;
+    TranspositionTable &tt;
+
+    SearchLimits limits;
+    U64 nodes;
+    U64 flushedNodes; //Part of nodes already added to the shared count
+    int rootDepth;
+
+    //Stop flag and node count, shared by all threads of a search pool
+    std::atomic<bool> _stop;
+    std::atomic<bool> &stop;
+    std::atomic<U64> *sharedNodes;
+    bool pooled;
+    int threadId; //0 is the main thread
+
+    //Set in ABDADA mode, helpers then search every depth and defer moves other threads are on
+    SearchingMarks *marks;
+    std::chrono::steady_clock::time_point start;
+
+    //Info line per finished depth
+    std::ostream *out;
+
+    //Triangular PV, row p holds the line found at ply p
+    Move pv[SEARCH_MAX_PLY][SEARCH_MAX_PLY];
+    int pvLength[SEARCH_MAX_PLY];
+
+    //Move ordering
+    Move killers[SEARCH_MAX_PLY][2];
+    std::unique_ptr<StandardHistory> history;
+
+    //Move made at each ply and the piece type that moved (Countermoves, continuation history)
+    Move moveStack[SEARCH_MAX_PLY];
+    U8 pieceStack[SEARCH_MAX_PLY];
+    #pragma endregion
+
+    /**
+     * MARKER Constructors
+     */
+    #pragma region
+    StandardSearch(StandardBoard &board, TranspositionTable &tt, std::ostream *out = nullptr,
+        std::atomic<bool> *sharedStop = nullptr, std::atomic<U64> *sharedNodes = nullptr, int threadId = 0)
+        : board(board), tt(tt), stop(sharedStop ? *sharedStop : _stop)
+    {
+        this->out = out;
+        this->_stop = false;
+        this->sharedNodes = sharedNodes;
+        this->pooled = sharedStop != nullptr;
+        this->threadId = threadId;
+        this->marks = nullptr;
+        this->history.reset(new StandardHistory());
+        this->nodes = 0;
+        this->flushedNodes = 0;
+        this->rootDepth = 0;
+    }
+    #pragma endregion
+
+    /**
+     * MARKER Iterative deepening
+     */
+    #pragma region
+    SearchResult search(const SearchLimits &limits)
+    {
+        this->limits = limits;
+        nodes = 0;
+        flushedNodes = 0;
+        start = std::chrono::steady_clock::now();
+
+        //A pool resets the shared flag and ages the table once for all threads
+        if(!pooled)
+        {
+            stop = false;
+            tt.newSearch();
+        }
+        for(int i = 0; i < SEARCH_MAX_PLY; i ++)
+            killers[i][0] = killers[i][1] = Move();
+        history->age();
+
+        SearchResult result;
+        int score = 0;
+
+        for(rootDepth = 1; rootDepth <= limits.depth && rootDepth < SEARCH_MAX_PLY; rootDepth ++)
+        {
+            if(threadId > 0 && !marks)
+            {
+                int i = (threadId - 1) % 20;
+                if(((rootDepth + SEARCH_SKIP_PHASE[i]) / SEARCH_SKIP_SIZE[i]) % 2)
+                    continue;
+            }
+
+            int alpha = -SCORE_INFINITE;
+            int beta = SCORE_INFINITE;
+            int delta = SEARCH_ASPIRATION_DELTA;
+
+            if(rootDepth >= SEARCH_ASPIRATION_DEPTH)
+            {
+                alpha = std::max(score - delta, -SCORE_INFINITE);
+                beta = std::min(score + delta, SCORE_INFINITE);
+            }
+
+            //Widen the window on the failing side until the score fits
+            while(true)
+            {
+                score = _negamax(alpha, beta, rootDepth, 0);
+
+                if(stop)
+                    break;
+
+                if(score <= alpha)
+                {
+                    beta = (alpha + beta) / 2;
+                    alpha = std::max(score - delta, -SCORE_INFINITE);
+                }
+                else if(score >= beta)
+                    beta = std::min(score + delta, SCORE_INFINITE);
+                else
+                    break;
+
+                delta *= 2;
+            }
+
+            //An unfinished iteration is dropped
+            if(stop)
+                break;
+
+            result.bestMove = pvLength[0] > 0 ? pv[0][0] : Move();
+            result.score = score;
+            result.depth = rootDepth;
+            result.pvLength = pvLength[0];
+            for(int i = 0; i < pvLength[0]; i ++)
+                result.pv[i] = pv[0][i];
+
+            _flushNodes();
+            result.nodes = totalNodes();
+            result.ms = elapsed();
+
+            if(out)
+                printInfo(result, *out);
+
+            //No legal moves, mate found, or the next depth would not finish in time
+            if(!result.bestMove.isValid() || std::abs(score) >= SCORE_MATE_BOUND || (limits.timeMs && result.ms * 2 > limits.timeMs))
+                break;
+        }
+
+        _flushNodes();
+        result.nodes = totalNodes();
+        result.ms = elapsed();
+        return result;
+    }
+
+    double elapsed() const
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start).count() / 1000.0;
+    }
+
+    //Nodes of all threads (Shared count is updated every 2048 nodes and after each depth)
+    U64 totalNodes() const
+    {
+        return sharedNodes ? sharedNodes->load(std::memory_order_relaxed) : nodes;
+    }
+
+    //Add the nodes searched since the last flush to the shared count
+    void _flushNodes()
+    {
+        if(sharedNodes)
+            sharedNodes->fetch_add(nodes - flushedNodes, std::memory_order_relaxed);
+
+        flushedNodes = nodes;
+    }
+
+    void _countNodes()
+    {
+        _flushNodes();
+        _checkLimits();
+    }
+
+    //Depth 1 always finishes, so there is a move to play
+    void _checkLimits()
+    {
+        if(rootDepth <= 1)
+            return;
+
+        if((limits.nodes && totalNodes() >= limits.nodes) || (limits.timeMs && elapsed() >= limits.timeMs))
+            stop = true;
+    }
+    #pragma endregion
+
+    /**
+     * MARKER Alpha-beta
+     */
+    #pragma region
+    int _negamax(int alpha, int beta, int depth, int ply)
+    {
+        pvLength[ply] = ply;
+        bool root = ply == 0;
+        bool pvNode = beta - alpha > 1;
+
+        if(!root)
+        {
+            if(board.isDraw())
+                return 0;
+
+            if(ply >= SEARCH_MAX_PLY - 1)
+                return evaluate(board);
+
+            //Mate distance pruning
+            alpha = std::max(alpha, -SCORE_MATE + ply);
+            beta = std::min(beta, SCORE_MATE - ply - 1);
+            if(alpha >= beta)
+                return alpha;
+        }
+
+        if(depth <= 0)
+            return _quiescence(alpha, beta, ply);
+
+        if((++nodes & SEARCH_CHECK_NODES) == 0)
+            _countNodes();
+
+        if(stop)
+            return 0;
+
+        //Transposition table
+        U64 key = board.state().key;
+        TTData entry;
+        bool hit = tt.probe(key, entry);
+        Move hashMove = hit ? entry.move : Move();
+
+        if(hit && !pvNode && entry.depth >= depth)
+        {
+            int score = scoreFromTT(entry.score, ply);
+
+            if(entry.bound == TT_BOUND_EXACT || (entry.bound == TT_BOUND_LOWER && score >= beta) || (entry.bound == TT_BOUND_UPPER && score <= alpha))
+                return score;
+        }
+
+        bool inCheck = board.playerIsInCheck(board.currentPlayer);
+
+        //Check extension
+        if(inCheck)
+            depth ++;
+
+        //Previous move (None at the root)
+        int previousPiece = ply > 0 ? pieceStack[ply - 1] : -1;
+        int previousTo = ply > 0 ? moveStack[ply - 1].to() : 0;
+        Move counterMove = previousPiece >= 0 ? history->counterMoves[previousPiece][previousTo] : Move();
+        const int *continuation = previousPiece >= 0 ? &history->continuation[previousPiece][previousTo][0][0] : nullptr;
+
+        StandardMovePicker picker(board, hashMove, killers[ply][0], killers[ply][1], GEN_ALL, history.get(), counterMove, continuation);
+        int originalAlpha = alpha;
+        int best = -SCORE_INFINITE;
+        Move bestMove;
+        int moveCount = 0;
+        Move move;
+
+        //Quiet moves that failed to cut off
+        Move quiets[SEARCH_MAX_QUIETS];
+        U8 quietPieces[SEARCH_MAX_QUIETS];
+        int quietCount = 0;
+
+        //ABDADA, moves another thread is searching are put off to the end
+        MoveList deferred;
+        size_t deferredIndex = 0;
+
+        while(true)
+        {
+            bool isDeferred = false;
+            move = picker.next();
+
+            if(!move.isValid())
+            {
+                if(deferredIndex == deferred.size())
+                    break;
+
+                move = deferred[deferredIndex++];
+                isDeferred = true;
+            }
+
+            //The first move is always searched right away (Young brothers wait)
+            U64 moveHash = 0;
+            if(marks && moveCount > 0 && depth >= SEARCH_ABDADA_DEPTH)
+            {
+                moveHash = _moveHash(key, move);
+
+                if(!isDeferred && marks->isSearching(moveHash))
+                {
+                    deferred.push_back(move);
+                    continue;
+                }
+
+                marks->start(moveHash);
+            }
+
+            moveCount ++;
+
+            bool quiet = !move.isCapture() && !move.isPromotion();
+            moveStack[ply] = move;
+            pieceStack[ply] = board.pieceTypeOn(move.from());
+
+            board.doMove(move);
+            tt.prefetch(board.state().key);
+
+            int score;
+            if(moveCount == 1)
+                score = -_negamax(-beta, -alpha, depth - 1, ply + 1);
+            else
+            {
+                //Null window first, full window again only when it beats alpha
+                score = -_negamax(-alpha - 1, -alpha, depth - 1, ply + 1);
+                if(score > alpha && score < beta)
+                    score = -_negamax(-beta, -alpha, depth - 1, ply + 1);
+            }
+
+            board.undoMove(move);
+
+            if(moveHash)
+                marks->finish(moveHash);
+
+            if(stop)
+                return 0;
+
+            if(score > best)
+            {
+                best = score;
+
+                if(score > alpha)
+                {
+                    alpha = score;
+                    bestMove = move;
+                    _updatePV(ply, move);
+
+                    if(score >= beta)
+                    {
+                        if(quiet)
+                            _updateQuietHistory(ply, depth, move, previousPiece, previousTo, quiets, quietPieces, quietCount);
+                        break;
+                    }
+                }
+            }
+
+            if(quiet && quietCount < SEARCH_MAX_QUIETS)
+            {
+                quiets[quietCount] = move;
+                quietPieces[quietCount] = pieceStack[ply];
+                quietCount ++;
+            }
+        }
+
+        //Checkmate or stalemate
+        if(moveCount == 0)
+            return inCheck ? -SCORE_MATE + ply : 0;
+
+        U8 bound = best >= beta ? TT_BOUND_LOWER : best > originalAlpha ? TT_BOUND_EXACT : TT_BOUND_UPPER;
+        tt.store(key, bestMove, scoreToTT(best, ply), SCORE_NONE, depth, bound);
+
+        return best;
+    }
+
+    //Captures (And promotions) only, so the static evaluation is not taken in the middle of an exchange
+    int _quiescence(int alpha, int beta, int ply)
+    {
+        pvLength[ply] = ply;
+
+        if((++nodes & SEARCH_CHECK_NODES) == 0)
+            _countNodes();
+
+        if(stop)
+            return 0;
+
+        if(ply >= SEARCH_MAX_PLY - 1)
+            return evaluate(board);
+
+        bool pvNode = beta - alpha > 1;
+        U64 key = board.state().key;
+        TTData entry;
+        bool hit = tt.probe(key, entry);
+        Move hashMove = hit ? entry.move : Move();
+
+        if(hit && !pvNode)
+        {
+            int score = scoreFromTT(entry.score, ply);
+
+            if(entry.bound == TT_BOUND_EXACT || (entry.bound == TT_BOUND_LOWER && score >= beta) || (entry.bound == TT_BOUND_UPPER && score <= alpha))
+                return score;
+        }
+
+        bool inCheck = board.playerIsInCheck(board.currentPlayer);
+        int originalAlpha = alpha;
+        int staticEval = SCORE_NONE;
+        int best = -SCORE_MATE + ply;
+
+        //Stand pat (Not allowed in check, every evasion is searched instead)
+        if(!inCheck)
+        {
+            staticEval = hit && entry.eval != SCORE_NONE ? entry.eval : evaluate(board);
+            best = staticEval;
+
+            if(best >= beta)
+                return best;
+
+            alpha = std::max(alpha, best);
+        }
+
+        StandardMovePicker picker(board, hashMove, Move(), Move(), GEN_CAPTURES);
+        Move bestMove;
+        Move move;
+
+        while((move = picker.next()).isValid())
+        {
+            board.doMove(move);
+            int score = -_quiescence(-beta, -alpha, ply + 1);
+            board.undoMove(move);
+
+            if(stop)
+                return 0;
+
+            if(score > best)
+            {
+                best = score;
+
+                if(score > alpha)
+                {
+                    alpha = score;
+                    bestMove = move;
+                    _updatePV(ply, move);
+
+                    if(score >= beta)
+                        break;
+                }
+            }
+        }
+
+        U8 bound = best >= beta ? TT_BOUND_LOWER : best > originalAlpha ? TT_BOUND_EXACT : TT_BOUND_UPPER;
+        tt.store(key, bestMove, scoreToTT(best, ply), staticEval, 0, bound);
+
+        return best;
+    }
+    #pragma endregion
+
+    /**
+     * MARKER Search utils
+     */
+    #pragma region
+    //Move followed by the line of the child node
+    void _updatePV(int ply, Move move)
+    {
+        pv[ply][ply] = move;
+
+        for(int i = ply + 1; i < pvLength[ply + 1]; i ++)
+            pv[ply][i] = pv[ply + 1][i];
+
+        pvLength[ply] = std::max(pvLength[ply + 1], ply + 1);
+    }
+
+    //Never 0 (Free mark)
+    static U64 _moveHash(U64 key, Move move)
+    {
+        return (key ^ ((U64)move.data * 0x9E3779B97F4A7C15ULL)) | 1;
+    }
+
+    //Quiet cut off: killers, countermove, and history bonus for the move and malus for the quiets tried before it
+    void _updateQuietHistory(int ply, int depth, Move move, int previousPiece, int previousTo, const Move *quiets, const U8 *quietPieces, int quietCount)
+    {
+        if(killers[ply][0] != move)
+        {
+            killers[ply][1] = killers[ply][0];
+            killers[ply][0] = move;
+        }
+
+        if(previousPiece >= 0)
+            history->counterMoves[previousPiece][previousTo] = move;
+
+        U8 player = board.currentPlayer;
+        int bonus = std::min(depth * depth, SEARCH_HISTORY_BONUS_MAX);
+
+        history->update(player, move, pieceStack[ply], previousPiece, previousTo, bonus);
+
+        for(int i = 0; i < quietCount; i ++)
+            history->update(player, quiets[i], quietPieces[i], previousPiece, previousTo, -bonus);
+    }
+
+    //depth, score (cp or mate in moves), nodes, nps, time and the PV in game notation
+    void printInfo(const SearchResult &result, std::ostream &out)
+    {
+        out << "depth " << result.depth << " score ";
+
+        if(std::abs(result.score) >= SCORE_MATE_BOUND)
+        {
+            int plies = SCORE_MATE - std::abs(result.score);
+            out << "mate " << (result.score > 0 ? (plies + 1) / 2 : -(plies / 2));
+        }
+        else
+            out << "cp " << result.score;
+
+        out << " nodes " << result.nodes << " nps " << (U64)(result.ms > 0 ? result.nodes * 1000 / result.ms : 0) << " time " << (int)result.ms << " pv";
+
+        //Moves are named after being made
+        for(int i = 0; i < result.pvLength; i ++)
+        {
+            std::string name;
+            board.doMove(result.pv[i]);
+            board.stringifyMove(result.pv[i], name);
+            out << " " << name;
+        }
+
+        for(int i = result.pvLength - 1; i >= 0; i --)
+            board.undoMove(result.pv[i]);
+
+        out << std::endl;
+    }
+    #pragma endregion
+};
+#pragma endregion
+#endif
@@ -0,0 +1,216 @@
+/**
+ * 2aCE (Árnilsen's Adaptable Chess Engine)
+ * Copyright (C) 2021 Árnilsen Arthur Castilho Lopes
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef STANDARD_SMP_H
+#define STANDARD_SMP_H
+
+/**
+ * MARKER Includes
+ */
+#pragma region
+#include <atomic>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "search.hpp"
+#pragma endregion
+
+/**
+ * MARKER Parallel search modes
+ */
+#pragma region
+const int SMP_LAZY = 0;
+const int SMP_ABDADA = 1;
+
+const char *const SMP_MODE_NAMES[2] = {"lazy", "abdada"};
+#pragma endregion
+
+/**
+ * MARKER Search pool (Lazy SMP / ABDADA)
+ * 
+ * Every thread searches the same root on its own board copy, with its own killers and PV,
+ * and they only talk through the shared transposition table. In Lazy SMP helpers skip some
+ * depths so they run ahead of the main thread and fill the table with results it will probe.
+ * In ABDADA all threads search the same depth and defer the moves another thread is already
+ * searching (Searching marks), so siblings are split between threads instead of duplicated.
+ * Threads are created once and parked between searches
+ */
+#pragma region
+class StandardSearchPool
+{
+public:
+    struct Worker
+    {
+        StandardBoard board;
+        std::unique_ptr<StandardSearch> search;
+        std::thread thread;
+    };
+
+    /**
+     * MARKER Fields
+     */
+    #pragma region
+    TranspositionTable &tt;
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    int mode; //SMP_LAZY or SMP_ABDADA, may change between searches
+    std::unique_ptr<SearchingMarks> marks;
+
+    std::atomic<bool> stop;
+    std::atomic<U64> nodes;
+
+    //Parking
+    std::mutex lock;
+    std::condition_variable wake;
+    std::condition_variable idle;
+    U64 generation; //Incremented for every search, helpers wait for a new one
+    int running; //Helpers still searching
+    bool quit;
+    #pragma endregion
+
+    /**
+     * MARKER Constructors
+     */
+    #pragma region
+    StandardSearchPool(TranspositionTable &tt, int threads, std::ostream *out = nullptr, int mode = SMP_LAZY) : tt(tt)
+    {
+        this->mode = mode;
+
+        if(threads < 1)
+            threads = 1;
+
+        stop = false;
+        nodes = 0;
+        generation = 0;
+        running = 0;
+        quit = false;
+
+        for(int i = 0; i < threads; i ++)
+        {
+            workers.push_back(std::unique_ptr<Worker>(new Worker()));
+
+            Worker &worker = *workers[i];
+            worker.search.reset(new StandardSearch(worker.board, tt, i == 0 ? out : nullptr, &stop, &nodes, i));
+        }
+
+        //Worker 0 runs on the calling thread
+        for(int i = 1; i < threads; i ++)
+            workers[i]->thread = std::thread(&StandardSearchPool::_park, this, i);
+    }
+
+    ~StandardSearchPool()
+    {
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            quit = true;
+        }
+        wake.notify_all();
+
+        for(size_t i = 1; i < workers.size(); i ++)
+            workers[i]->thread.join();
+    }
+
+    StandardSearchPool(const StandardSearchPool &) = delete;
+    StandardSearchPool &operator=(const StandardSearchPool &) = delete;
+    #pragma endregion
+
+    /**
+     * MARKER Search
+     */
+    #pragma region
+    //Searches the position with all threads, limits apply to the main thread (Nodes are counted for all)
+    SearchResult search(const StandardBoard &position, const SearchLimits &limits)
+    {
+        for(std::unique_ptr<Worker> &worker : workers)
+            worker->board = position;
+
+        stop = false;
+        nodes = 0;
+        tt.newSearch();
+
+        //Marks are only needed with helpers
+        SearchingMarks *searching = nullptr;
+        if(mode == SMP_ABDADA && workers.size() > 1)
+        {
+            if(!marks)
+                marks.reset(new SearchingMarks());
+            else
+                marks->clear();
+
+            searching = marks.get();
+        }
+
+        for(std::unique_ptr<Worker> &worker : workers)
+            worker->search->marks = searching;
+
+        {
+            std::lock_guard<std::mutex> guard(lock);
+            generation ++;
+            running = (int)workers.size() - 1;
+        }
+        wake.notify_all();
+
+        SearchResult result = workers[0]->search->search(limits);
+
+        //Helpers only stop with the main thread
+        stop = true;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            idle.wait(guard, [this] { return running == 0; });
+        }
+
+        result.nodes = 0;
+        for(std::unique_ptr<Worker> &worker : workers)
+            result.nodes += worker->search->nodes;
+
+        return result;
+    }
+
+    //Helper loop, waits for a new search, runs it without limits and parks again
+    void _park(int id)
+    {
+        Worker &worker = *workers[id];
+        U64 seen = 0;
+
+        while(true)
+        {
+            {
+                std::unique_lock<std::mutex> guard(lock);
+                wake.wait(guard, [this, seen] { return quit || generation != seen; });
+
+                if(quit)
+                    return;
+
+                seen = generation;
+            }
+
+            worker.search->search(SearchLimits());
+
+            {
+                std::lock_guard<std::mutex> guard(lock);
+                running --;
+            }
+            idle.notify_all();
+        }
+    }
+    #pragma endregion
+};
+#pragma endregion
+#endif
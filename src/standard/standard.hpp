@@ -23,8 +23,10 @@
  * MARKER Includes
  */
 #pragma region
-#include "../AttackLine.hpp"
+#include "../magic.hpp"
+#include "zobrist.hpp"
 #include <cstring>
+#include <algorithm>
 #pragma endregion
 
 /**
@@ -40,6 +42,16 @@ const U8 STANDARD_PT_KNIGHT = 5;
 char piecesChars[6] = {'P','K','Q','B','R','N'};
 #pragma endregion
 
+/**
+ * MARKER Piece values (Centipawns, indexed by piece type)
+ */
+#pragma region
+const int STANDARD_PIECE_VALUES[6] = {100, 20000, 900, 330, 500, 320};
+
+//Piece types from the least to the most valuable (Static exchange attackers)
+const U8 STANDARD_SEE_ORDER[6] = {STANDARD_PT_PAWN, STANDARD_PT_KNIGHT, STANDARD_PT_BISHOP, STANDARD_PT_ROOK, STANDARD_PT_QUEEN, STANDARD_PT_KING};
+#pragma endregion
+
 /**
  * MARKER Player Ids
  */
@@ -49,46 +61,121 @@ const U8 STANDARD_PLAYER_BLACK = 1;
 #pragma endregion
 
 /**
- * MARKER Moves
+ * MARKER Promotions (Move promotion index -> Piece type)
  */
 #pragma region
-const unsigned int MOVE_VALID = 1 << 1; //DONE
-const unsigned int MOVE_CAPTURE = 1 << 2; //DONE
-const unsigned int MOVE_DOUBLE_PAWN = 1 << 3; //DONE
-const unsigned int MOVE_KING_SIDE_CASTLING = 1 << 4;
-const unsigned int MOVE_QUEEN_SIDE_CASTLING = 1 << 5;
-const unsigned int MOVE_EN_PASSANT = 1 << 6;
-const unsigned int MOVE_PROMOTION = 1 << 7; //DONE
+const U8 STANDARD_PROMOTIONS[4] = {STANDARD_PT_KNIGHT,STANDARD_PT_BISHOP,STANDARD_PT_ROOK,STANDARD_PT_QUEEN};
 #pragma endregion
 
 /**
  * MARKER Ranks (Rows)
  */ 
 #pragma region
-Bitboard RANK_1 = 0xffull;
-Bitboard RANK_2 = 0xff00ull;
-Bitboard RANK_3 = 0xff0000ull;
-Bitboard RANK_4 = 0xff000000ull;
-Bitboard RANK_5 = 0xff00000000ull;
-Bitboard RANK_6 = 0xff0000000000ull;
-Bitboard RANK_7 = 0xff000000000000ull;
-Bitboard RANK_8 = 0xff00000000000000ull;
-Bitboard RANKS[8] = {RANK_1,RANK_2,RANK_3,RANK_4,RANK_5,RANK_6,RANK_7,RANK_8};
+constexpr Bitboard88 RANK_1 = 0xffull;
+constexpr Bitboard88 RANK_2 = 0xff00ull;
+constexpr Bitboard88 RANK_3 = 0xff0000ull;
+constexpr Bitboard88 RANK_4 = 0xff000000ull;
+constexpr Bitboard88 RANK_5 = 0xff00000000ull;
+constexpr Bitboard88 RANK_6 = 0xff0000000000ull;
+constexpr Bitboard88 RANK_7 = 0xff000000000000ull;
+constexpr Bitboard88 RANK_8 = 0xff00000000000000ull;
+constexpr Bitboard88 RANKS[8] = {RANK_1,RANK_2,RANK_3,RANK_4,RANK_5,RANK_6,RANK_7,RANK_8};
 #pragma endregion
 
 /**
  * MARKER Files (Columns)
  */
 #pragma region 
-Bitboard BFILE_H = 0x8080808080808080ull;
-Bitboard BFILE_G = 0x4040404040404040ull;
-Bitboard BFILE_F = 0x2020202020202020ull;
-Bitboard BFILE_E = 0x1010101010101010ull;
-Bitboard BFILE_D = 0x808080808080808ull;
-Bitboard BFILE_C = 0x404040404040404ull;
-Bitboard BFILE_B = 0x202020202020202ull;
-Bitboard BFILE_A = 0x101010101010101ull;
-Bitboard FILES[8] = {BFILE_A,BFILE_B,BFILE_C,BFILE_D,BFILE_E,BFILE_F,BFILE_G,BFILE_H};
+constexpr Bitboard88 BFILE_H = 0x8080808080808080ull;
+constexpr Bitboard88 BFILE_G = 0x4040404040404040ull;
+constexpr Bitboard88 BFILE_F = 0x2020202020202020ull;
+constexpr Bitboard88 BFILE_E = 0x1010101010101010ull;
+constexpr Bitboard88 BFILE_D = 0x808080808080808ull;
+constexpr Bitboard88 BFILE_C = 0x404040404040404ull;
+constexpr Bitboard88 BFILE_B = 0x202020202020202ull;
+constexpr Bitboard88 BFILE_A = 0x101010101010101ull;
+constexpr Bitboard88 FILES[8] = {BFILE_A,BFILE_B,BFILE_C,BFILE_D,BFILE_E,BFILE_F,BFILE_G,BFILE_H};
+#pragma endregion
+
+/**
+ * MARKER Castling rights (Bits of the state castling rights)
+ */
+#pragma region
+const U8 STANDARD_CASTLING_WK = 1;
+const U8 STANDARD_CASTLING_WQ = 2;
+const U8 STANDARD_CASTLING_BK = 4;
+const U8 STANDARD_CASTLING_BQ = 8;
+const U8 STANDARD_CASTLING_ALL = 15;
+
+//Rights kept when a piece leaves or lands on a square (King and rook home squares)
+const U8 STANDARD_CASTLING_MASK[64] = {
+    13, 15, 15, 15, 12, 15, 15, 14,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+    15, 15, 15, 15, 15, 15, 15, 15,
+     7, 15, 15, 15,  3, 15, 15, 11
+};
+#pragma endregion
+
+/**
+ * MARKER State info
+ * 
+ * Everything a move can't undo by itself, one entry per ply.
+ * Entries live in a preallocated ring addressed by index, so boards stay copyable
+ */
+#pragma region
+const int STANDARD_STATE_STACK_SIZE = 1024; //Power of two, undo depth limit
+
+struct StandardStateInfo
+{
+    U8 castlingRights = STANDARD_CASTLING_ALL;
+    int enpassant = -1;
+    U8 captured = NO_PIECE; //Piece type captured by the move that led here
+    int halfmoveClock = 0;
+    U64 key = 0; //Zobrist key
+    Bitboard88 checkers; //Pieces giving check to the side to move
+};
+#pragma endregion
+
+/**
+ * MARKER Color traits (Side to move as a compile-time parameter)
+ */
+#pragma region
+//Shift towards higher squares for positive deltas
+template <int Delta>
+constexpr Bitboard88 _shift88(const Bitboard88 &board)
+{
+    return Delta > 0 ? board << Delta : board >> -Delta;
+}
+
+template <U8 Us>
+struct StandardColor
+{
+    static constexpr U8 them = Us == STANDARD_PLAYER_WHITE ? STANDARD_PLAYER_BLACK : STANDARD_PLAYER_WHITE;
+
+    //Square deltas (Push, capture towards file A, capture towards file H)
+    static constexpr int up = Us == STANDARD_PLAYER_WHITE ? 8 : -8;
+    static constexpr int westCapture = Us == STANDARD_PLAYER_WHITE ? 7 : -9;
+    static constexpr int eastCapture = Us == STANDARD_PLAYER_WHITE ? 9 : -7;
+
+    //First square of the back rank
+    static constexpr int home = Us == STANDARD_PLAYER_WHITE ? 0 : 56;
+
+    static constexpr U8 kingSideCastling = Us == STANDARD_PLAYER_WHITE ? STANDARD_CASTLING_WK : STANDARD_CASTLING_BK;
+    static constexpr U8 queenSideCastling = Us == STANDARD_PLAYER_WHITE ? STANDARD_CASTLING_WQ : STANDARD_CASTLING_BQ;
+
+    static constexpr Bitboard88 doublePushRank = Us == STANDARD_PLAYER_WHITE ? RANK_4 : RANK_5;
+    static constexpr Bitboard88 promotionRank = Us == STANDARD_PLAYER_WHITE ? RANK_8 : RANK_1;
+
+    //Squares attacked by pawns of this player
+    static constexpr Bitboard88 pawnAttacks(const Bitboard88 &pawns)
+    {
+        return (_shift88<westCapture>(pawns) & ~BFILE_H) | (_shift88<eastCapture>(pawns) & ~BFILE_A);
+    }
+};
 #pragma endregion
 
 /**
@@ -102,7 +189,7 @@ Bitboard FILES[8] = {BFILE_A,BFILE_B,BFILE_C,BFILE_D,BFILE_E,BFILE_F,BFILE_G,BFI
  * - Undo Support
  */
 #pragma region 
-class StandardBoard : public Board
+class StandardBoard : public Board<64>
 {
     public:  
         /**
@@ -113,25 +200,31 @@ class StandardBoard : public Board
         std::string _playercolor[2];
 
         //Optmization
-        Bitboard otherPieces;
-        Bitboard playerPiecesInverse;
+        Bitboard88 otherPieces;
+        Bitboard88 playerPiecesInverse;
 
         //Temporary variables
         U8 otherPlayer;
-
-        //Attack situation (Legal move optimization)
-        std::vector<AttackLine> directAttackLines;
-        std::vector<AttackLine> blockedAttackLines;
-        Bitboard captureAttackingPieces;
-        Bitboard attackBlockers;
-        Bitboard attackedSquares;
+        U8 genType = GEN_ALL;
+        Bitboard88 sourceMask;
+
+        //Check situation (Legal move generation)
+        int kingSquare = -1;
+        Bitboard88 checkers;
+        Bitboard88 pinned;
+        Bitboard88 checkMask;
+        Bitboard88 targetMask;
+        Bitboard88 attackedSquares;
         
-        //Castling info
-        int castlingInfo[2][3]; //Player: KingMoves, QSRookMoves, KSRookMoves
+        //State stack (Castling, en passant, captured piece, clocks, keys)
+        StandardStateInfo _states[STANDARD_STATE_STACK_SIZE];
+        int _stateIndex = 0;
+
+        //Plies since the game start (Fullmove number)
+        int gamePly = 0;
 
-        //En-passant information
-        std::vector<U8> enpassantHistory;
-        int enpassant = -1;
+        //Game ply of the loaded position, older states are not known (Repetitions)
+        int _loadPly = 0;
         #pragma endregion
 
         /**
@@ -140,8 +233,7 @@ class StandardBoard : public Board
         StandardBoard()
         {
             //Int all squares as valid
-            valid = Bitboard(false);
-            valid.main = u64one;
+            valid = Bitboard88(u64one);
 
             //Clear all data
             clear();
@@ -200,28 +292,26 @@ class StandardBoard : public Board
             //Clear all pieces
             for(int i = 0; i < 2;i ++)
                 for(int j = 0; j < 7; j ++)
-                    _pieces[i][j] = Bitboard(0);
-
-            //Castling
-            castlingInfo[0][0] = 0;
-            castlingInfo[0][1] = 0;
-            castlingInfo[0][2] = 0;
-            castlingInfo[1][0] = 0;
-            castlingInfo[1][1] = 0;
-            castlingInfo[1][2] = 0;
-
-            //EnPassant
-            enpassantHistory = std::vector<U8>();
-            enpassant = -1;
-
-            directAttackLines.clear();
-            blockedAttackLines.clear();
-
-            captureAttackingPieces.clear();
-            attackBlockers = Bitboard(0);
-            attackedSquares  = Bitboard(0);
-            _occupied = Bitboard(0);
-            _notoccupied = Bitboard(0);
+                    _pieces[i][j] = Bitboard88(0);
+
+            _clearMailbox();
+
+            //State (All castling rights, no en passant)
+            currentPlayer = STANDARD_PLAYER_WHITE;
+            _stateIndex = 0;
+            _states[0] = StandardStateInfo();
+            _states[0].key = computeKey();
+            gamePly = 0;
+            _loadPly = 0;
+
+            kingSquare = -1;
+            checkers.clear();
+            pinned.clear();
+            checkMask.clear();
+            targetMask.clear();
+            attackedSquares  = Bitboard88(0);
+            _occupied = Bitboard88(0);
+            _notoccupied = Bitboard88(0);
             
             _occupied = _pieces[STANDARD_PLAYER_WHITE][6] | _pieces[STANDARD_PLAYER_BLACK][6];
             _notoccupied = ~_occupied;
@@ -246,20 +336,13 @@ class StandardBoard : public Board
                     if(((valid.main) >> (pos)) & 1)
                     {   
                         //Pieces
-                        bool b = false;
-                        for(U8 player = 0; player < 2; player ++)
-                            for(U8 type = 0; type < 6; type ++)
-                            {
-                                if(((_pieces[player][type].main) >> (pos)) & 1)
-                                {
-                                    printf(_playercolor[player].c_str());
-                                    b = true;
-                                    printf("%c ",piecesChars[type]);
-                                    printf(CSL_Reset);
-                                }
-                            }
-
-                        if(!b)
+                        if(_mailbox[pos] != NO_PIECE)
+                        {
+                            printf(_playercolor[playerOn(pos)].c_str());
+                            printf("%c ",piecesChars[pieceTypeOn(pos)]);
+                            printf(CSL_Reset);
+                        }
+                        else
                             printf(". ");
                     }
                     else
@@ -281,15 +364,10 @@ class StandardBoard : public Board
                 int empty = 0;
                 for(U8 column = 0; column < 8; column ++)
                 {
-                    int player = 0;
-                    U8 piecetype = getPiece(0,row * 8 + column);
-                    if(piecetype == 255)
-                    {
-                        player = 1;
-                        piecetype = getPiece(1,row * 8 + column);
-                    }
+                    int player = playerOn(row * 8 + column);
+                    U8 piecetype = pieceTypeOn(row * 8 + column);
 
-                    if(piecetype == 255)
+                    if(piecetype == NO_PIECE)
                     {
                         empty ++;
                     }
@@ -316,14 +394,15 @@ class StandardBoard : public Board
             s += (currentPlayer == 0 ? " w " : " b ");
             
             std::string castlingstr = "";
+            U8 rights = state().castlingRights;
 
-            if(castlingInfo[0][0] == 0 && castlingInfo[0][2] == 0)
+            if(rights & STANDARD_CASTLING_WK)
                 castlingstr += "K";
-            if(castlingInfo[1][0] == 0 && castlingInfo[1][2] == 0)
-                castlingstr += "k";
-            if(castlingInfo[0][0] == 0 && castlingInfo[0][1] == 0)
+            if(rights & STANDARD_CASTLING_WQ)
                 castlingstr += "Q";
-            if(castlingInfo[1][0] == 0 && castlingInfo[1][1] == 0)
+            if(rights & STANDARD_CASTLING_BK)
+                castlingstr += "k";
+            if(rights & STANDARD_CASTLING_BQ)
                 castlingstr += "q";
 
             if(castlingstr.length() > 0)
@@ -332,6 +411,7 @@ class StandardBoard : public Board
                 s += "-";
 
             s += " ";
+            int enpassant = state().enpassant;
             if(enpassant == -1)
                 s += "-";
             else
@@ -343,6 +423,9 @@ class StandardBoard : public Board
                 s += (row + 49);
             }
 
+            //Clocks
+            s += " " + std::to_string(state().halfmoveClock) + " " + std::to_string(gamePly / 2 + 1);
+
             output = s;
         }
 
@@ -362,7 +445,7 @@ class StandardBoard : public Board
             }
 
             //Hold data
-            Bitboard data[2][6] = {{Bitboard(0),Bitboard(0),Bitboard(0),Bitboard(0),Bitboard(0),Bitboard(0)},{Bitboard(0),Bitboard(0),Bitboard(0),Bitboard(0),Bitboard(0),Bitboard(0)}};
+            Bitboard88 data[2][6] = {{Bitboard88(0),Bitboard88(0),Bitboard88(0),Bitboard88(0),Bitboard88(0),Bitboard88(0)},{Bitboard88(0),Bitboard88(0),Bitboard88(0),Bitboard88(0),Bitboard88(0),Bitboard88(0)}};
             //Parse data
             for(int row = 0; row < 8; row ++)
             {
@@ -454,7 +537,7 @@ class StandardBoard : public Board
             }
 
             //Castling data
-            int castinfo[2][3] = {{0,1,1},{0,1,1}};
+            U8 castlingrights = 0;
 
             if(v.size() > 2)
             {
@@ -464,16 +547,16 @@ class StandardBoard : public Board
                         switch (c)
                         {
                             case 'K':
-                                castinfo[0][2] = 0;
+                                castlingrights |= STANDARD_CASTLING_WK;
                                 break;
                             case 'Q':
-                                castinfo[0][1] = 0;
+                                castlingrights |= STANDARD_CASTLING_WQ;
                                 break;
                             case 'k':
-                                castinfo[1][2] = 0;
+                                castlingrights |= STANDARD_CASTLING_BK;
                                 break;
                             case 'q':
-                                castinfo[1][1] = 0;
+                                castlingrights |= STANDARD_CASTLING_BQ;
                                 break;
                             
                             default:
@@ -498,7 +581,11 @@ class StandardBoard : public Board
                     {
                         int column = v[3][0] - 97;
                         int row = v[3][1] - 49;
-                        enpassantinfo = row * 8 + column;
+                        int pawnrow = player == STANDARD_PLAYER_WHITE ? 4 : 3;
+
+                        //Only a square skipped by the last double push (Enemy pawn behind it), anything else is dropped
+                        if(column < 8 && row == (player == STANDARD_PLAYER_WHITE ? 5 : 2) && data[player ^ 1][STANDARD_PT_PAWN].get(pawnrow * 8 + column))
+                            enpassantinfo = row * 8 + column;
                     }
                     else
                     {
@@ -506,6 +593,15 @@ class StandardBoard : public Board
                         return;
                     }
             }
+
+            //Clocks (Optional)
+            int halfmoveclock = 0;
+            int fullmove = 1;
+
+            if(v.size() > 4 && !v[4].empty() && isdigit(v[4][0]))
+                halfmoveclock = std::stoi(v[4]);
+            if(v.size() > 5 && !v[5].empty() && isdigit(v[5][0]))
+                fullmove = std::max(1,std::stoi(v[5]));
             
 
             //Clear data
@@ -518,21 +614,25 @@ class StandardBoard : public Board
             _pieces[STANDARD_PLAYER_WHITE][6] = _pieces[STANDARD_PLAYER_WHITE][5] | _pieces[STANDARD_PLAYER_WHITE][4] | _pieces[STANDARD_PLAYER_WHITE][3] | _pieces[STANDARD_PLAYER_WHITE][2] | _pieces[STANDARD_PLAYER_WHITE][1] | _pieces[STANDARD_PLAYER_WHITE][0];
             _pieces[STANDARD_PLAYER_BLACK][6] = _pieces[STANDARD_PLAYER_BLACK][5] | _pieces[STANDARD_PLAYER_BLACK][4] | _pieces[STANDARD_PLAYER_BLACK][3] | _pieces[STANDARD_PLAYER_BLACK][2] | _pieces[STANDARD_PLAYER_BLACK][1] | _pieces[STANDARD_PLAYER_BLACK][0];
 
+            for(U8 i = 0; i < 2; i ++)
+                for(U8 j = 0; j < 6; j ++)
+                    for (int pos : _pieces[i][j])
+                        _mailbox[pos] = _mailboxPiece(i,j);
+
             _occupied = _pieces[STANDARD_PLAYER_WHITE][6] | _pieces[STANDARD_PLAYER_BLACK][6];
             _notoccupied = ~_occupied;
 
             currentPlayer = player;
 
-            castlingInfo[0][0] = castinfo[0][0];
-            castlingInfo[0][1] = castinfo[0][1];
-            castlingInfo[0][2] = castinfo[0][2];
-            castlingInfo[1][0] = castinfo[1][0];
-            castlingInfo[1][1] = castinfo[1][1];
-            castlingInfo[1][2] = castinfo[1][2];
+            StandardStateInfo &st = state();
+            st.castlingRights = castlingrights;
+            st.enpassant = enpassantinfo;
+            st.halfmoveClock = halfmoveclock;
+            gamePly = 2 * (fullmove - 1) + player;
+            _loadPly = gamePly;
 
-            enpassant = enpassantinfo;
-            enpassantHistory.push_back(enpassant);
-            
+            st.key = computeKey();
+            _updateCheckers();
         }
         
 
@@ -545,22 +645,20 @@ class StandardBoard : public Board
         void setPiece(U8 player,U8 piecetype,U8 pos)
         {
             _addPiece(player,piecetype,pos);
+            _updateCheckers();
         }   
 
         U8 getPiece(U8 player,U8 pos)
         {
-            Bitboard square = u64a1 << pos;
-            if ((square & _pieces[player][0]).has()) return 0;
-            else if ((square & _pieces[player][1]).has()) return 1;
-            else if ((square & _pieces[player][2]).has()) return 2;
-            else if ((square & _pieces[player][3]).has()) return 3;
-            else if ((square & _pieces[player][4]).has()) return 4;
-            else if ((square & _pieces[player][5]).has()) return 5;
-
-            return 255;
+            U8 piece = _mailbox[pos];
+
+            if(piece == NO_PIECE || (piece >> 4) != player)
+                return NO_PIECE;
+
+            return piece & 15;
         }
 
-        Bitboard getPieces(U8 player,U8 piecetype)
+        Bitboard88 getPieces(U8 player,U8 piecetype)
         {
             return _pieces[player][piecetype];
         }   
@@ -572,6 +670,9 @@ class StandardBoard : public Board
         #pragma region
         bool playerIsInCheck(U8 player)
         {   
+            if(player == currentPlayer)
+                return state().checkers.has();
+
             int i = _pieces[player][STANDARD_PT_KING].bitScanForward();
 
             if(i == -1)
@@ -580,912 +681,1170 @@ class StandardBoard : public Board
             return squareIsUnderAttack(player,i);
         }
 
-        bool squareIsUnderAttack(U8 player,U8 pos)
+        //Fifty move rule or a repetition since the last capture or pawn move
+        bool isDraw() const
         {
-            Bitboard square = u64a1 << pos;
-            U8 other = player == 0 ? 1 : 0;
+            const StandardStateInfo &st = state();
 
-            //Pawn attacks
-            #pragma region Pawn
-            Bitboard pawns = _pieces[other][0];
+            if(st.halfmoveClock >= 100)
+                return true;
 
-            if(other == 0)
-            {
-                if(((pawns << 7) & ~BFILE_H & square).has())
-                    return true;
-                if(((pawns << 9) & ~BFILE_A & square).has())
-                    return true;
-            }
-            else
-            {
-                if(((pawns >> 7) & ~BFILE_A & square).has())
-                    return true;
-                if(((pawns >> 9) & ~BFILE_H & square).has())
-                    return true;
-            }
-            #pragma endregion
+            int limit = std::min(st.halfmoveClock, gamePly - _loadPly);
+            limit = std::min(limit, STANDARD_STATE_STACK_SIZE - 1);
 
-            //King attacks
-            #pragma region King
-            Bitboard kings = _pieces[other][STANDARD_PT_KING];
-            
-            while (kings.has())
-                if((border88[kings.bitScanPopNext()] & square).has())
+            for (int i = 4; i <= limit; i += 2)
+                if(_states[(_stateIndex - i) & (STANDARD_STATE_STACK_SIZE - 1)].key == st.key)
                     return true;
 
-            #pragma endregion
-        
-            //Queen attacks
-            #pragma region Queen
-            Bitboard queens = (_pieces[other][STANDARD_PT_QUEEN]);
+            return false;
+        }
 
-            while (queens.has())
-            {
-                unsigned int pos = queens.bitScanPopNext();
-                
-                //All moves
-                Bitboard all = genRayMoves(pos,NORTH,other,false) | genRayMoves(pos,SOUTH,other,true) | genRayMoves(pos,EAST,other,false) | genRayMoves(pos,WEST,other,true) | genRayMoves(pos,NORTH_EAST,other,false) | genRayMoves(pos,SOUTH_EAST,other,true) | genRayMoves(pos,NORTH_WEST,other,false) | genRayMoves(pos,SOUTH_WEST,other,true);
+        bool squareIsUnderAttack(U8 player,U8 pos)
+        {
+            return squareIsUnderAttack(player,pos,_occupied);
+        }
 
-                if((all & square).has())
-                    return true;
-            }
-            #pragma endregion
+        //Attack test on a custom occupancy (Sliders see through removed pieces)
+        bool squareIsUnderAttack(U8 player,U8 pos,const Bitboard88 &occupied)
+        {
+            if(sliderBackend == SLIDER_PEXT)
+                return player == STANDARD_PLAYER_WHITE ? _squareIsUnderAttack<STANDARD_PLAYER_WHITE,SLIDER_PEXT>(pos,occupied) : _squareIsUnderAttack<STANDARD_PLAYER_BLACK,SLIDER_PEXT>(pos,occupied);
 
-            //Rook attacks
-            #pragma region Rook
-            Bitboard rooks = (_pieces[other][STANDARD_PT_ROOK]);
+            return player == STANDARD_PLAYER_WHITE ? _squareIsUnderAttack<STANDARD_PLAYER_WHITE,SLIDER_MAGIC>(pos,occupied) : _squareIsUnderAttack<STANDARD_PLAYER_BLACK,SLIDER_MAGIC>(pos,occupied);
+        }
 
-            while (rooks.has())
-            {
-                unsigned int pos = rooks.bitScanPopNext();
-                
-                //All moves
-                Bitboard all = genRayMoves(pos,NORTH,other,false) | genRayMoves(pos,SOUTH,other,true) | genRayMoves(pos,EAST,other,false) | genRayMoves(pos,WEST,other,true);
+        template <U8 Us,SliderBackend Backend>
+        bool _squareIsUnderAttack(U8 pos,const Bitboard88 &occupied)
+        {
+            const U8 them = StandardColor<Us>::them;
+            Bitboard88 square = u64a1 << pos;
 
-                if((all & square).has())
-                    return true;
-            }
+            //Pawn attacks (Our capture pattern from the square hits their pawns)
+            #pragma region Pawn
+            if((StandardColor<Us>::pawnAttacks(square) & _pieces[them][STANDARD_PT_PAWN]).has())
+                return true;
             #pragma endregion
 
-            //Bishop attacks
-            #pragma region Bishop
-            Bitboard bishops = (_pieces[other][STANDARD_PT_BISHOP]);
+            //King attacks
+            #pragma region King
+            Bitboard88 kings = _pieces[them][STANDARD_PT_KING];
+            
+            if((border88[pos] & kings).has())
+                return true;
 
-            while (bishops.has())
-            {
-                unsigned int pos = bishops.bitScanPopNext();
-                
-                //All moves
-                Bitboard all = genRayMoves(pos,NORTH_EAST,other,false) | genRayMoves(pos,SOUTH_EAST,other,true) | genRayMoves(pos,NORTH_WEST,other,false) | genRayMoves(pos,SOUTH_WEST,other,true);
-                if((all & square).has())
-                    return true;
-            }
+            #pragma endregion
+        
+            //Slider attacks (Reverse lookup from target square)
+            #pragma region Sliders
+            Bitboard88 rooks = _pieces[them][STANDARD_PT_ROOK] | _pieces[them][STANDARD_PT_QUEEN];
+            Bitboard88 bishops = _pieces[them][STANDARD_PT_BISHOP] | _pieces[them][STANDARD_PT_QUEEN];
+
+            if((rookAttacks<Backend>(pos,occupied) & rooks).has())
+                return true;
+            if((bishopAttacks<Backend>(pos,occupied) & bishops).has())
+                return true;
             #pragma endregion
 
             //Knight attacks
             #pragma region Knight
-            Bitboard knights = _pieces[other][STANDARD_PT_KNIGHT];
+            Bitboard88 knights = _pieces[them][STANDARD_PT_KNIGHT];
             
-            while (knights.has())
-                if((knight88[knights.bitScanPopNext()] & square).has())
-                    return true;
+            if((knight88[pos] & knights).has())
+                return true;
 
             #pragma endregion
 
             return false;
         }
+
+        //Pieces of both players attacking a square on a custom occupancy (Sliders see through removed pieces)
+        Bitboard88 attackersTo(int pos,const Bitboard88 &occupied) const
+        {
+            return sliderBackend == SLIDER_PEXT ? _allAttackersTo<SLIDER_PEXT>(pos,occupied) : _allAttackersTo<SLIDER_MAGIC>(pos,occupied);
+        }
+
+        template <SliderBackend Backend>
+        Bitboard88 _allAttackersTo(int pos,const Bitboard88 &occupied) const
+        {
+            Bitboard88 square = u64a1 << pos;
+            Bitboard88 rooks = _pieces[0][STANDARD_PT_ROOK] | _pieces[0][STANDARD_PT_QUEEN] | _pieces[1][STANDARD_PT_ROOK] | _pieces[1][STANDARD_PT_QUEEN];
+            Bitboard88 bishops = _pieces[0][STANDARD_PT_BISHOP] | _pieces[0][STANDARD_PT_QUEEN] | _pieces[1][STANDARD_PT_BISHOP] | _pieces[1][STANDARD_PT_QUEEN];
+
+            return (knight88[pos] & (_pieces[0][STANDARD_PT_KNIGHT] | _pieces[1][STANDARD_PT_KNIGHT]))
+                 | (border88[pos] & (_pieces[0][STANDARD_PT_KING] | _pieces[1][STANDARD_PT_KING]))
+                 | (rookAttacks<Backend>(pos,occupied) & rooks)
+                 | (bishopAttacks<Backend>(pos,occupied) & bishops)
+                 | (StandardColor<STANDARD_PLAYER_BLACK>::pawnAttacks(square) & _pieces[STANDARD_PLAYER_WHITE][STANDARD_PT_PAWN])
+                 | (StandardColor<STANDARD_PLAYER_WHITE>::pawnAttacks(square) & _pieces[STANDARD_PLAYER_BLACK][STANDARD_PT_PAWN]);
+        }
         #pragma endregion
 
         /**
-         * MARKER Moves
+         * MARKER Static exchange evaluation
+         * 
+         * Material outcome of the capture sequence on the move destination, both sides
+         * recapture with their least valuable attacker and may stop when it stops paying.
+         * Sliders behind a used attacker join in (X-rays). Pins and recapture promotions are ignored
          */
-        #pragma region            
-        void doMove(Move &move)
+        #pragma region
+        //Value won by the move (Captured piece plus promotion gain)
+        int _seeGain(Move move) const
         {
-            //Enpassant generation
-            U8 other = currentPlayer == 0 ? 1 : 0;
+            int gain = 0;
 
-            if(move.piecetype == STANDARD_PT_KING)
-                castlingInfo[currentPlayer][0] ++;
-            if((Bitboard(u64a1 << move.from) & Bitboard(FILE_A)).has() && move.piecetype == STANDARD_PT_ROOK)
-                castlingInfo[currentPlayer][1] ++;
-            if((Bitboard(u64a1 << move.from) & Bitboard(FILE_H)).has() && move.piecetype == STANDARD_PT_ROOK)
-                castlingInfo[currentPlayer][2] ++;
+            if(move.isEnPassant())
+                gain = STANDARD_PIECE_VALUES[STANDARD_PT_PAWN];
+            else if(move.isCapture())
+                gain = STANDARD_PIECE_VALUES[pieceTypeOn(move.to())];
 
-            if(move.flag & MOVE_EN_PASSANT)
-            {
-                if(currentPlayer == 1)
-                    _removePiece(other,STANDARD_PT_PAWN,move.to + 8);
-                else if(currentPlayer == 0)
-                    _removePiece(other,STANDARD_PT_PAWN,move.to - 8);
-            }
+            if(move.isPromotion())
+                gain += STANDARD_PIECE_VALUES[STANDARD_PROMOTIONS[move.promotion()]] - STANDARD_PIECE_VALUES[STANDARD_PT_PAWN];
 
-            if(move.flag & MOVE_DOUBLE_PAWN)
-                enpassant = (move.to + move.from)/2;
-            else
-                enpassant = -1;
+            return gain;
+        }
 
-            enpassantHistory.push_back(enpassant);
+        //Piece standing on the destination after the move
+        int _seeMovedValue(Move move) const
+        {
+            return STANDARD_PIECE_VALUES[move.isPromotion() ? STANDARD_PROMOTIONS[move.promotion()] : pieceTypeOn(move.from())];
+        }
 
-            if(move.flag & MOVE_CAPTURE)
+        //Occupancy without the moving piece (En passant also removes the captured pawn), the destination does not block its own attackers
+        Bitboard88 _seeOccupied(Move move) const
+        {
+            Bitboard88 occupied = _occupied ^ (u64a1 << move.from());
+
+            if(move.isEnPassant())
+                occupied ^= u64a1 << (move.to() + (currentPlayer == STANDARD_PLAYER_WHITE ? -8 : 8));
+
+            return occupied;
+        }
+
+        //Least valuable attacker of a player (NO_PIECE if none), its square is returned in pos
+        U8 _seeLeastValuable(U8 player,const Bitboard88 &attackers,int &pos) const
+        {
+            for (U8 type : STANDARD_SEE_ORDER)
             {
-                move.capturedpiecetype = getPiece(other,move.to);
-                if(move.capturedpiecetype == 255)
+                Bitboard88 pieces = attackers & _pieces[player][type];
+                if(pieces.has())
                 {
-                   
+                    pos = pieces.bitScanForward();
+                    return type;
                 }
-
-                _removePiece(other,move.capturedpiecetype,move.to);
             }
 
-            _movePiece(currentPlayer,move.piecetype,move.from,move.to);
-            
-            if(move.flag & MOVE_PROMOTION)
+            return NO_PIECE;
+        }
+
+        //Sliders uncovered after a piece of the given type left the square
+        template <SliderBackend Backend>
+        Bitboard88 _seeXrays(U8 type,int pos,const Bitboard88 &occupied) const
+        {
+            Bitboard88 xrays;
+
+            if(type == STANDARD_PT_PAWN || type == STANDARD_PT_BISHOP || type == STANDARD_PT_QUEEN)
+                xrays |= bishopAttacks<Backend>(pos,occupied) & (_pieces[0][STANDARD_PT_BISHOP] | _pieces[0][STANDARD_PT_QUEEN] | _pieces[1][STANDARD_PT_BISHOP] | _pieces[1][STANDARD_PT_QUEEN]);
+
+            if(type == STANDARD_PT_ROOK || type == STANDARD_PT_QUEEN)
+                xrays |= rookAttacks<Backend>(pos,occupied) & (_pieces[0][STANDARD_PT_ROOK] | _pieces[0][STANDARD_PT_QUEEN] | _pieces[1][STANDARD_PT_ROOK] | _pieces[1][STANDARD_PT_QUEEN]);
+
+            return xrays;
+        }
+
+        //Exchange value of a move in centipawns (Swap list)
+        int see(Move move) const
+        {
+            return sliderBackend == SLIDER_PEXT ? _see<SLIDER_PEXT>(move) : _see<SLIDER_MAGIC>(move);
+        }
+
+        template <SliderBackend Backend>
+        int _see(Move move) const
+        {
+            if(move.isKingSideCastling() || move.isQueenSideCastling())
+                return 0;
+
+            int to = move.to();
+            int gain[32];
+            int depth = 0;
+
+            gain[0] = _seeGain(move);
+            int attackerValue = _seeMovedValue(move);
+
+            Bitboard88 occupied = _seeOccupied(move);
+            Bitboard88 attackers = _allAttackersTo<Backend>(to,occupied) & occupied;
+            U8 player = currentPlayer ^ 1;
+
+            while (depth < 31)
             {
-                _removePiece(currentPlayer,move.piecetype,move.to);
-                _addPiece(currentPlayer,move.promotionpiecetype,move.to);
+                int pos;
+                U8 type = _seeLeastValuable(player,attackers,pos);
+                if(type == NO_PIECE)
+                    break;
+
+                //The king can not take a defended piece
+                if(type == STANDARD_PT_KING && (attackers & _pieces[player ^ 1][6]).has())
+                    break;
+
+                //Balance for this side if it takes the piece on the square
+                depth ++;
+                gain[depth] = attackerValue - gain[depth - 1];
+
+                occupied ^= u64a1 << pos;
+                attackers |= _seeXrays<Backend>(type,to,occupied);
+                attackers &= occupied;
+
+                attackerValue = STANDARD_PIECE_VALUES[type];
+                player ^= 1;
             }
 
-            if(move.flag & MOVE_KING_SIDE_CASTLING)
+            //Each side may stop capturing when going on loses
+            while (depth > 0)
             {
-                _movePiece(currentPlayer,STANDARD_PT_ROOK,move.to + 1,move.to - 1);
+                gain[depth - 1] = -std::max(-gain[depth - 1],gain[depth]);
+                depth --;
             }
 
-            if(move.flag & MOVE_QUEEN_SIDE_CASTLING)
+            return gain[0];
+        }
+
+        //True if the exchange value of a move is at least the threshold (Stops as soon as the answer is known)
+        bool seeGE(Move move,int threshold) const
+        {
+            return sliderBackend == SLIDER_PEXT ? _seeGE<SLIDER_PEXT>(move,threshold) : _seeGE<SLIDER_MAGIC>(move,threshold);
+        }
+
+        template <SliderBackend Backend>
+        bool _seeGE(Move move,int threshold) const
+        {
+            if(move.isKingSideCastling() || move.isQueenSideCastling())
+                return threshold <= 0;
+
+            int to = move.to();
+
+            //Even if the piece is taken back for free
+            int swap = _seeGain(move) - threshold;
+            if(swap < 0)
+                return false;
+
+            //Even if the moved piece is lost
+            swap = _seeMovedValue(move) - swap;
+            if(swap <= 0)
+                return true;
+
+            Bitboard88 occupied = _seeOccupied(move);
+            Bitboard88 attackers = _allAttackersTo<Backend>(to,occupied);
+            U8 player = currentPlayer;
+            int result = 1;
+
+            while (true)
             {
-                _movePiece(currentPlayer,STANDARD_PT_ROOK,move.to -2,move.to + 1);
+                player ^= 1;
+                attackers &= occupied;
+
+                int pos;
+                U8 type = _seeLeastValuable(player,attackers,pos);
+                if(type == NO_PIECE)
+                    break;
+
+                result ^= 1;
+
+                //Taking with the king only works if the other side has nothing left
+                if(type == STANDARD_PT_KING)
+                    return (attackers & _pieces[player ^ 1][6]).has() ? result ^ 1 : result;
+
+                swap = STANDARD_PIECE_VALUES[type] - swap;
+                if(swap < result)
+                    break;
+
+                occupied ^= u64a1 << pos;
+                attackers |= _seeXrays<Backend>(type,to,occupied);
             }
 
-            currentPlayer = currentPlayer == 0 ? 1 : 0;
+            return result;
         }
+        #pragma endregion
 
-        //Undo board move
-        void undoMove(Move &move)
+        /**
+         * MARKER Moves
+         */
+        #pragma region            
+        void doMove(Move move)
         {
-            U8 other = currentPlayer;
-            currentPlayer = currentPlayer == 0 ? 1 : 0;
+            if(sliderBackend == SLIDER_PEXT)
+            {
+                if(currentPlayer == STANDARD_PLAYER_WHITE)
+                    _doMove<STANDARD_PLAYER_WHITE,SLIDER_PEXT>(move);
+                else
+                    _doMove<STANDARD_PLAYER_BLACK,SLIDER_PEXT>(move);
+            }
+            else if(currentPlayer == STANDARD_PLAYER_WHITE)
+                _doMove<STANDARD_PLAYER_WHITE,SLIDER_MAGIC>(move);
+            else
+                _doMove<STANDARD_PLAYER_BLACK,SLIDER_MAGIC>(move);
+        }
 
-            enpassantHistory.pop_back();
+        template <U8 Us,SliderBackend Backend>
+        void _doMove(Move move)
+        {
+            typedef StandardColor<Us> Color;
+            const U8 them = Color::them;
+
+            U8 from = move.from();
+            U8 to = move.to();
+            U8 piecetype = pieceTypeOn(from);
+
+            //New state from the previous one
+            const StandardStateInfo &previous = state();
+            _stateIndex = (_stateIndex + 1) & (STANDARD_STATE_STACK_SIZE - 1);
+            StandardStateInfo &st = state();
+
+            st.castlingRights = previous.castlingRights & STANDARD_CASTLING_MASK[from] & STANDARD_CASTLING_MASK[to];
+            st.enpassant = move.isDoublePawn() ? to - Color::up : -1;
+            st.halfmoveClock = (piecetype == STANDARD_PT_PAWN || move.isCapture()) ? 0 : previous.halfmoveClock + 1;
+            st.captured = NO_PIECE;
+
+            //Key (Pieces are updated by the piece utils)
+            st.key = previous.key ^ ZOBRIST.side;
+            st.key ^= ZOBRIST.castling[previous.castlingRights] ^ ZOBRIST.castling[st.castlingRights];
+            if(previous.enpassant != -1)
+                st.key ^= ZOBRIST.enpassant[previous.enpassant % 8];
+            if(st.enpassant != -1)
+                st.key ^= ZOBRIST.enpassant[st.enpassant % 8];
+
+            if(move.isEnPassant())
+            {
+                _removePiece(them,STANDARD_PT_PAWN,to - Color::up);
+            }
+            else if(move.isCapture())
+            {
+                st.captured = pieceTypeOn(to);
+                _removePiece(them,st.captured,to);
+            }
 
-            if(enpassantHistory.size() > 0)
-                enpassant = enpassantHistory[enpassantHistory.size() - 1];
+            if(move.isPromotion())
+            {
+                _removePiece(Us,STANDARD_PT_PAWN,from);
+                _addPiece(Us,STANDARD_PROMOTIONS[move.promotion()],to);
+            }
             else
-                enpassant = -1;
+                _movePiece(Us,piecetype,from,to);
 
-            if(move.flag & MOVE_EN_PASSANT)
+            if(move.isKingSideCastling())
             {
-                if(currentPlayer == 1)
-                    _addPiece(other,STANDARD_PT_PAWN,move.to + 8);
-                else if(currentPlayer == 0)
-                    _addPiece(other,STANDARD_PT_PAWN,move.to - 8);
+                _movePiece(Us,STANDARD_PT_ROOK,Color::home + 7,Color::home + 5);
             }
 
-            if(move.flag & MOVE_KING_SIDE_CASTLING)
+            if(move.isQueenSideCastling())
             {
-                _movePiece(currentPlayer,STANDARD_PT_ROOK,move.to - 1,move.to + 1);
+                _movePiece(Us,STANDARD_PT_ROOK,Color::home,Color::home + 3);
             }
 
-            if(move.flag & MOVE_QUEEN_SIDE_CASTLING)
+            currentPlayer = them;
+            gamePly ++;
+
+            //Checks given by the move
+            int king = _pieces[them][STANDARD_PT_KING].bitScanForward();
+            st.checkers = king == -1 ? Bitboard88() : _attackersTo<Us,Backend>(king);
+
+            #ifdef STANDARD_DEBUG_HASH
+            _checkKey("doMove");
+            #endif
+        }
+
+        //Undo board move
+        void undoMove(Move move)
+        {
+            //The move was made by the player before the current one
+            if(currentPlayer == STANDARD_PLAYER_WHITE)
+                _undoMove<STANDARD_PLAYER_BLACK>(move);
+            else
+                _undoMove<STANDARD_PLAYER_WHITE>(move);
+        }
+
+        template <U8 Us>
+        void _undoMove(Move move)
+        {
+            typedef StandardColor<Us> Color;
+            const U8 them = Color::them;
+
+            currentPlayer = Us;
+            gamePly --;
+
+            U8 from = move.from();
+            U8 to = move.to();
+
+            if(move.isKingSideCastling())
+            {
+                _movePiece(Us,STANDARD_PT_ROOK,Color::home + 5,Color::home + 7);
+            }
+
+            if(move.isQueenSideCastling())
             {
-                _movePiece(currentPlayer,STANDARD_PT_ROOK,move.to + 1,move.to - 2);
+                _movePiece(Us,STANDARD_PT_ROOK,Color::home + 3,Color::home);
             }
 
-            if(move.flag & MOVE_PROMOTION)
+            if(move.isPromotion())
             {
-                _removePiece(currentPlayer,move.promotionpiecetype,move.to);
-                _addPiece(currentPlayer,move.piecetype,move.to);
+                _removePiece(Us,STANDARD_PROMOTIONS[move.promotion()],to);
+                _addPiece(Us,STANDARD_PT_PAWN,from);
             }
+            else
+                _movePiece(Us,pieceTypeOn(to),to,from);
 
-            _movePiece(currentPlayer,move.piecetype,move.to,move.from);
+            if(move.isEnPassant())
+                _addPiece(them,STANDARD_PT_PAWN,to - Color::up);
+            else if(state().captured != NO_PIECE)
+                _addPiece(them,state().captured,to);
 
-            if(move.flag & MOVE_CAPTURE)
-                _addPiece(other,move.capturedpiecetype,move.to);  
+            //Previous state is still intact
+            _stateIndex = (_stateIndex - 1) & (STANDARD_STATE_STACK_SIZE - 1);
 
-            if(move.piecetype == STANDARD_PT_KING)
-                castlingInfo[currentPlayer][0] --; 
-            if((Bitboard(u64a1 << move.from) & Bitboard(FILE_A)).has() && move.piecetype == STANDARD_PT_ROOK)
-                castlingInfo[currentPlayer][1] --;
-            if((Bitboard(u64a1 << move.from) & Bitboard(FILE_H)).has() && move.piecetype == STANDARD_PT_ROOK)
-                castlingInfo[currentPlayer][2] --;
+            #ifdef STANDARD_DEBUG_HASH
+            _checkKey("undoMove");
+            #endif
         }
 
         //Generate all legal moves
         void genMoves()
         {
-            moves.clear();
             legalMoves.clear();
+            genMoves(legalMoves,GEN_ALL);
+        }
 
-            U8 p = currentPlayer;
-            //Gen attacks
-            int targetpiece = _pieces[p][STANDARD_PT_KING].bitScanForward();
-            Bitboard targetsSquares = border88[targetpiece];
-            Bitboard targetPieces = u64a1 << targetpiece;
-            genAttacks(targetsSquares,targetPieces,targetpiece,p == 0 ? 1 : 0);
-
-            moves = MoveList();
+        //Generate legal moves of a type (Captures/Quiets), optionally only for the pieces on sources
+        void genMoves(MoveList &list,U8 type,Bitboard88 sources = u64one)
+        {
+            if(sliderBackend == SLIDER_PEXT)
+            {
+                if(currentPlayer == STANDARD_PLAYER_WHITE)
+                    _genMoves<STANDARD_PLAYER_WHITE,SLIDER_PEXT>(list,type,sources);
+                else
+                    _genMoves<STANDARD_PLAYER_BLACK,SLIDER_PEXT>(list,type,sources);
+            }
+            else if(currentPlayer == STANDARD_PLAYER_WHITE)
+                _genMoves<STANDARD_PLAYER_WHITE,SLIDER_MAGIC>(list,type,sources);
+            else
+                _genMoves<STANDARD_PLAYER_BLACK,SLIDER_MAGIC>(list,type,sources);
+        }
 
-            //Update Temp variables
-            playerPiecesInverse = ~_pieces[currentPlayer][6];
-            otherPieces = (_occupied & playerPiecesInverse);
-            otherPlayer = currentPlayer == 0 ? 1 : 0;
-            
-            //Pawns (DONE)           
-            genPawnMoves();
+        //Generate legal captures, en passant and promotions only (Quiescence)
+        void genCaptures(MoveList &list)
+        {
+            if(sliderBackend == SLIDER_PEXT)
+            {
+                if(currentPlayer == STANDARD_PLAYER_WHITE)
+                    _genCaptures<STANDARD_PLAYER_WHITE,SLIDER_PEXT>(list);
+                else
+                    _genCaptures<STANDARD_PLAYER_BLACK,SLIDER_PEXT>(list);
+            }
+            else if(currentPlayer == STANDARD_PLAYER_WHITE)
+                _genCaptures<STANDARD_PLAYER_WHITE,SLIDER_MAGIC>(list);
+            else
+                _genCaptures<STANDARD_PLAYER_BLACK,SLIDER_MAGIC>(list);
+        }
 
-            //Rooks (DONE)
-            genRooksMoves();
+        //Generate check evasions only (Falls back to all legal moves when not in check)
+        void genEvasions(MoveList &list)
+        {
+            if(sliderBackend == SLIDER_PEXT)
+            {
+                if(currentPlayer == STANDARD_PLAYER_WHITE)
+                    _genEvasions<STANDARD_PLAYER_WHITE,SLIDER_PEXT>(list);
+                else
+                    _genEvasions<STANDARD_PLAYER_BLACK,SLIDER_PEXT>(list);
+            }
+            else if(currentPlayer == STANDARD_PLAYER_WHITE)
+                _genEvasions<STANDARD_PLAYER_WHITE,SLIDER_MAGIC>(list);
+            else
+                _genEvasions<STANDARD_PLAYER_BLACK,SLIDER_MAGIC>(list);
+        }
 
-            //Bishop (DONE)
-            genBishopMoves();
+        template <U8 Us,SliderBackend Backend>
+        void _genMoves(MoveList &list,U8 type,Bitboard88 sources)
+        {
+            _genSetup<Us,Backend>(type,sources);
 
-            //Queen (DONE)
-            genQueenMoves();
+            //In check, only the replies to the check
+            if(checkers.has() && type == GEN_ALL && !(~sources).has())
+            {
+                _genCheckReplies<Us,Backend>(list);
+                return;
+            }
 
-            //Knights (DONE)
-            genKnightMoves();
+            //Squares the king can't go (Attacked squares see through the king)
+            genAttacks<StandardColor<Us>::them,Backend>(_pieces[Us][STANDARD_PT_KING]);
 
             //King (DONE)
-            genKingMoves();         
-            
-            //Clear legal moves
-            legalMoves.clear();
+            genKingMoves<Us>(list);
+
+            //Other pieces
+            _genPieces<Us,Backend>(list);
+        }
 
-            bool incheck = (attackedSquares & targetPieces).has();
+        template <U8 Us,SliderBackend Backend>
+        void _genCaptures(MoveList &list)
+        {
+            _genSetup<Us,Backend>(GEN_CAPTURES,Bitboard88(u64one));
 
-            for (auto move : moves) 
+            //King captures are checked one by one, no full attack map is built
+            if(kingSquare != -1)
             {
-                Bitboard from = u64a1 << move.from;
-                Bitboard target = u64a1 << move.to;
-                
-                //In Check
-                if(incheck)
-                {
-                    //Try to espace from attacked square
-                    if(targetpiece == move.from)
-                    {
-                        if(!(target & attackedSquares).has())
-                            legalMoves.push_back(move);
-                    }
-                    else
-                    {  
-                        //Check if can capture
-                        if(!(captureAttackingPieces & ~target).has())
-                            legalMoves.push_back(move);
-
-                        //Check if can protect
-                        if(directAttackLines.size() > 0)
-                            if((directAttackLines[0].squares & target).has())
-                                legalMoves.push_back(move);
-                    }
-                }
-                //Check if will move piece to attacked square
-                else if(targetpiece == move.from)
-                {
-                    if(!(target & attackedSquares).has())
-                        legalMoves.push_back(move);
-                }
-                else if(directAttackLines.size() > 0)
-                {
-                    if((directAttackLines[0].squares & target).has())
-                        legalMoves.push_back(move);
-                }
-                else if(blockedAttackLines.size() > 0)
-                {
-                    if((attackBlockers & from).has())
-                    {
-                        if((blockedAttackLines[0].squares & target).has())
-                            legalMoves.push_back(move);
-                    }
-                    else
-                        legalMoves.push_back(move);
-                }
-                else
-                    legalMoves.push_back(move);
-            }  
+                Bitboard88 xrayOccupied = _occupied & ~Bitboard88(u64a1 << kingSquare);
+
+                for (int to : border88[kingSquare] & otherPieces)
+                    if(!_squareIsUnderAttack<Us,Backend>(to,xrayOccupied))
+                        list.push_back(Move(kingSquare,to,MOVE_CAPTURE));
+            }
+
+            //Other pieces
+            _genPieces<Us,Backend>(list);
         }
 
-        //Generate all king moves
-        void genKingMoves()
-        {   
-            Bitboard kings = _pieces[currentPlayer][STANDARD_PT_KING];
-            
-            while (kings.has())
+        template <U8 Us,SliderBackend Backend>
+        void _genEvasions(MoveList &list)
+        {
+            _genSetup<Us,Backend>(GEN_ALL,Bitboard88(u64one));
+
+            if(!checkers.has())
             {
-                unsigned int pos = kings.bitScanPopNext();
-                Bitboard all = border88[pos] & playerPiecesInverse;
-                
-                //Captures
-                Bitboard captures = all & otherPieces;
-                
-                //No captures
-                Bitboard nocaptures = all & ~captures;
-                
-                while (nocaptures.has())
-                    moves.push_back(Move(pos,nocaptures.bitScanPopNext(),STANDARD_PT_KING,MOVE_VALID));
-                while (captures.has())
-                {
-                    int cpos = captures.bitScanPopNext();
+                genAttacks<StandardColor<Us>::them,Backend>(_pieces[Us][STANDARD_PT_KING]);
+                genKingMoves<Us>(list);
+                _genPieces<Us,Backend>(list);
+                return;
+            }
 
-                    Move m = Move(pos,cpos,STANDARD_PT_KING,MOVE_CAPTURE);
-                    moves.push_back(m);
-                }
+            _genCheckReplies<Us,Backend>(list);
+        }
 
-                //Castlings
-                Bitboard kingside = u64a1 << (pos + 3);
-                Bitboard queenside = u64a1 << (pos - 4);
+        //Evasions: king steps to safe squares, then capture or block a single checker
+        template <U8 Us,SliderBackend Backend>
+        void _genCheckReplies(MoveList &list)
+        {
+            typedef StandardColor<Us> Color;
+            Bitboard88 xrayOccupied = _occupied & ~Bitboard88(u64a1 << kingSquare);
 
-                Bitboard kingsidepath = currentPlayer == 0 ? Bitboard(15 << 4) : (Bitboard(15) << 60);
-                Bitboard queensidepath = currentPlayer == 0 ? Bitboard(31) : (Bitboard(31) << 56);
+            //King steps (Checked square by square, sliders see through the king)
+            for (int to : border88[kingSquare] & playerPiecesInverse)
+                if(!_squareIsUnderAttack<Us,Backend>(to,xrayOccupied))
+                    list.push_back(Move(kingSquare,to,otherPieces.get(to) ? MOVE_CAPTURE : MOVE_QUIET));
 
-                if(castlingInfo[currentPlayer][0] == 0 && castlingInfo[currentPlayer][2] == 0 && (kingsidepath & _occupied).popCount() == 2)
-                    if(!(kingsidepath & attackedSquares).has() && (kingside & _pieces[currentPlayer][STANDARD_PT_ROOK]).has())
-                    {
-                        //Add kingside
-                        Move m = Move(pos,pos + 2,STANDARD_PT_KING,MOVE_KING_SIDE_CASTLING);
-                        moves.push_back(m);
-                    }
+            //Double check, only the king can move
+            if(checkers.popCount() > 1)
+                return;
 
-                if(castlingInfo[currentPlayer][1] == 0 && castlingInfo[currentPlayer][1] == 0 && (queensidepath & _occupied).popCount() == 2)
-                    if(!(queensidepath & attackedSquares).has() && (queenside & _pieces[currentPlayer][STANDARD_PT_ROOK]).has())
-                    {
-                        //Add kingside
-                        Move m = Move(pos,pos - 2,STANDARD_PT_KING,MOVE_QUEEN_SIDE_CASTLING);
-                        moves.push_back(m);
-                    }
+            //Pinned pieces can never answer a check
+            int checker = checkers.bitScanForward();
+            Bitboard88 defenders = _pieces[Us][6] & ~pinned & ~_pieces[Us][STANDARD_PT_KING];
+            Bitboard88 pawns = _pieces[Us][STANDARD_PT_PAWN] & defenders;
+
+            //Capture the checker
+            for (int from : _attackersTo<Us,Backend>(checker) & defenders)
+            {
+                if(pawns.get(from) && Color::promotionRank.get(checker))
+                    _addPromotions(list,from,checker,MOVE_PROMOTION_CAPTURE);
+                else
+                    list.push_back(Move(from,checker,MOVE_CAPTURE));
             }
-        }
 
-        //Generate all pawn moves
-        void genPawnMoves()
-        {
-            if(currentPlayer == 0)
+            //Block the checking line (Empty squares only)
+            for (int to : between88[kingSquare][checker])
             {
-                //Pawn single moves
-                Bitboard pawns = _pieces[currentPlayer][0];
-                Bitboard pawnsm = (pawns << 8) & _notoccupied;
-                Bitboard pawndm = (pawnsm << 8) & _notoccupied & RANK_4;
-                
-                //Gen pawn promotions
-                Bitboard pawnpromo = pawnsm & RANK_8;
-                pawnsm &= ~RANK_8;
+                for (int from : _attackersTo<Us,Backend>(to) & defenders & ~pawns)
+                    list.push_back(Move(from,to,MOVE_QUIET));
 
-                Bitboard pawnlc = (pawns << 7) & otherPieces & ~BFILE_H & ~RANK_8;
-                Bitboard pawnrc = (pawns << 9) & otherPieces & ~BFILE_A & ~RANK_8;
+                //Pawn pushes
+                int from = to - Color::up;
 
-                Bitboard pawnlcpromo = (pawns << 7) & otherPieces & ~BFILE_H & RANK_8;
-                Bitboard pawnrcpromo = (pawns << 9) & otherPieces & ~BFILE_A & RANK_8;
- 
-                while (pawnsm.has())
-                {
-                    unsigned int pos = pawnsm.bitScanPopNext();
-                    moves.push_back(Move(pos - 8,pos,STANDARD_PT_PAWN,MOVE_VALID));
-                }
+                if(from < 0 || from >= 64)
+                    continue;
 
-                while (pawndm.has())
+                if(pawns.get(from))
                 {
-                    unsigned int pos = pawndm.bitScanPopNext();
-                    moves.push_back(Move(pos - 16,pos,STANDARD_PT_PAWN,MOVE_DOUBLE_PAWN));
+                    if(Color::promotionRank.get(to))
+                        _addPromotions(list,from,to,MOVE_PROMOTION);
+                    else
+                        list.push_back(Move(from,to,MOVE_QUIET));
                 }
+                else if(!_occupied.get(from) && Color::doublePushRank.get(to) && pawns.get(from - Color::up))
+                    list.push_back(Move(from - Color::up,to,MOVE_DOUBLE_PAWN));
+            }
 
-                while (pawnlc.has())
-                {
-                    unsigned int pos = pawnlc.bitScanPopNext();
+            //En passant (Checker is the pushed pawn, or the capture blocks the line)
+            if(state().enpassant != -1)
+                _genEnPassant<Us,Backend>(list,_pieces[Us][STANDARD_PT_PAWN]);
+        }
 
-                    Move m(pos - 7,pos,STANDARD_PT_PAWN,MOVE_CAPTURE);
-                    moves.push_back(m);
-                }
+        //Pieces of a player attacking a square (Reverse lookup, pawns use the other side pattern)
+        template <U8 Us,SliderBackend Backend>
+        Bitboard88 _attackersTo(int pos)
+        {
+            Bitboard88 square = u64a1 << pos;
+            Bitboard88 rooks = _pieces[Us][STANDARD_PT_ROOK] | _pieces[Us][STANDARD_PT_QUEEN];
+            Bitboard88 bishops = _pieces[Us][STANDARD_PT_BISHOP] | _pieces[Us][STANDARD_PT_QUEEN];
+
+            return (knight88[pos] & _pieces[Us][STANDARD_PT_KNIGHT])
+                 | (border88[pos] & _pieces[Us][STANDARD_PT_KING])
+                 | (rookAttacks<Backend>(pos,_occupied) & rooks)
+                 | (bishopAttacks<Backend>(pos,_occupied) & bishops)
+                 | (StandardColor<StandardColor<Us>::them>::pawnAttacks(square) & _pieces[Us][STANDARD_PT_PAWN]);
+        }
 
-                while (pawnrc.has())
-                {
-                    unsigned int pos = pawnrc.bitScanPopNext();
+        //Add one move for each promotion piece
+        void _addPromotions(MoveList &list,int from,int to,U8 flag)
+        {
+            for (U8 promotion = 0; promotion < sizeof(STANDARD_PROMOTIONS); promotion ++)
+                list.push_back(Move(from,to,flag | promotion));
+        }
 
-                    Move m(pos - 9,pos,STANDARD_PT_PAWN,MOVE_CAPTURE);
-                    moves.push_back(m);
-                }
+        //Check situation and masks shared by all generators
+        template <U8 Us,SliderBackend Backend>
+        void _genSetup(U8 type,Bitboard88 sources)
+        {
+            otherPlayer = StandardColor<Us>::them;
 
-            
-                //Promotions
-                while (pawnpromo.has())
-                {
-                    unsigned int pos = pawnpromo.bitScanPopNext();
-                    Move mva(pos - 8,pos,STANDARD_PT_PAWN,MOVE_PROMOTION);
-                    mva.promotionpiecetype = STANDARD_PT_ROOK;
-                    moves.push_back(mva);
-
-                    Move mvb(pos - 8,pos,STANDARD_PT_PAWN,MOVE_PROMOTION);
-                    mvb.promotionpiecetype = STANDARD_PT_QUEEN;
-                    moves.push_back(mvb);
-
-                    Move mvc(pos - 8,pos,STANDARD_PT_PAWN,MOVE_PROMOTION);
-                    mvc.promotionpiecetype = STANDARD_PT_BISHOP;
-                    moves.push_back(mvc);
-
-                    Move mvd(pos - 8,pos,STANDARD_PT_PAWN,MOVE_PROMOTION);
-                    mvd.promotionpiecetype = STANDARD_PT_KNIGHT;
-                    moves.push_back(mvd);
-                }
+            //Check situation (checkers and pinned pieces)
+            kingSquare = _pieces[Us][STANDARD_PT_KING].bitScanForward();
+            genCheckInfo<Us,Backend>();
 
-                while (pawnrcpromo.has())
-                {
-                    unsigned int pos = pawnrcpromo.bitScanPopNext();
+            //Update Temp variables
+            playerPiecesInverse = ~_pieces[Us][6];
+            otherPieces = (_occupied & playerPiecesInverse);
+            genType = type;
+            sourceMask = sources;
+
+            //Destinations of the requested type
+            Bitboard88 typeMask;
+            if(type & GEN_CAPTURES)
+                typeMask |= otherPieces;
+            if(type & GEN_QUIETS)
+                typeMask |= _notoccupied;
+
+            checkMask = playerPiecesInverse;
+            targetMask = checkMask & typeMask;
+        }
 
-                    Move m(pos - 9,pos,STANDARD_PT_PAWN,MOVE_CAPTURE | MOVE_PROMOTION);
-                    m.promotionpiecetype = STANDARD_PT_ROOK;
-                    moves.push_back(m);
+        //Generate the moves of all pieces but the king
+        template <U8 Us,SliderBackend Backend>
+        void _genPieces(MoveList &list)
+        {
+            //Double check, only the king can move
+            if(checkers.popCount() > 1)
+                return;
 
-                    Move mb(pos - 9,pos,STANDARD_PT_PAWN,MOVE_CAPTURE | MOVE_PROMOTION);
-                    mb.promotionpiecetype = STANDARD_PT_KNIGHT;
-                    moves.push_back(mb);
+            //Single check, capture the checker or block the checking line
+            if(checkers.has())
+            {
+                checkMask &= checkers | between88[kingSquare][checkers.bitScanForward()];
+                targetMask &= checkMask;
+            }
 
-                    Move mc(pos - 9,pos,STANDARD_PT_PAWN,MOVE_CAPTURE | MOVE_PROMOTION);
-                    mc.promotionpiecetype = STANDARD_PT_QUEEN;
-                    moves.push_back(mc);
+            //Pawns (DONE)           
+            genPawnMoves<Us,Backend>(list);
 
-                    Move md(pos - 9,pos,STANDARD_PT_PAWN,MOVE_CAPTURE | MOVE_PROMOTION);
-                    md.promotionpiecetype = STANDARD_PT_BISHOP;
-                    moves.push_back(md);
-                }
+            //Rooks (DONE)
+            genRooksMoves<Us,Backend>(list);
 
-                while (pawnlcpromo.has())
-                {
-                    unsigned int pos = pawnlcpromo.bitScanPopNext();
+            //Bishop (DONE)
+            genBishopMoves<Us,Backend>(list);
 
-                    Move m(pos - 7,pos,STANDARD_PT_PAWN,MOVE_CAPTURE | MOVE_PROMOTION);
-                    m.promotionpiecetype = STANDARD_PT_ROOK;
-                    moves.push_back(m);
+            //Queen (DONE)
+            genQueenMoves<Us,Backend>(list);
 
-                    Move mb(pos - 7,pos,STANDARD_PT_PAWN,MOVE_CAPTURE | MOVE_PROMOTION);
-                    mb.promotionpiecetype = STANDARD_PT_KNIGHT;
-                    moves.push_back(mb);
+            //Knights (DONE)
+            genKnightMoves<Us>(list);
+        }
 
-                    Move mc(pos - 7,pos,STANDARD_PT_PAWN,MOVE_CAPTURE | MOVE_PROMOTION);
-                    mc.promotionpiecetype = STANDARD_PT_QUEEN;
-                    moves.push_back(mc);
+        //Check if a move (Hash move, killer) is legal in the current position
+        bool isLegalMove(Move move)
+        {
+            if(!move.isValid())
+                return false;
 
-                    Move md(pos - 7,pos,STANDARD_PT_PAWN,MOVE_CAPTURE | MOVE_PROMOTION);
-                    md.promotionpiecetype = STANDARD_PT_BISHOP;
-                    moves.push_back(md);
-                }
+            if(sliderBackend == SLIDER_PEXT)
+                return currentPlayer == STANDARD_PLAYER_WHITE ? _isLegalMove<STANDARD_PLAYER_WHITE,SLIDER_PEXT>(move) : _isLegalMove<STANDARD_PLAYER_BLACK,SLIDER_PEXT>(move);
 
-                if(enpassant != -1)
-                {
-                    Bitboard enpa = ((u64a1 << enpassant));
+            return currentPlayer == STANDARD_PLAYER_WHITE ? _isLegalMove<STANDARD_PLAYER_WHITE,SLIDER_MAGIC>(move) : _isLegalMove<STANDARD_PLAYER_BLACK,SLIDER_MAGIC>(move);
+        }
 
-                    while(pawns.has())
-                    {
-                        unsigned int pos = pawns.bitScanPopNext();
-                        Bitboard pawn = u64a1 << pos;
-                        Bitboard bothcaptures = ((pawn << 7) & ~BFILE_H) | ((pawn << 9) & ~BFILE_A);
+        //Same answer as searching the generated moves, without the generator setup (Reach and flags, then the king safety after the move)
+        template <U8 Us,SliderBackend Backend>
+        bool _isLegalMove(Move move)
+        {
+            typedef StandardColor<Us> Color;
+            const U8 them = Color::them;
 
-                        if((bothcaptures & enpa).has())
-                            moves.push_back(Move(pos,enpassant,STANDARD_PT_PAWN,MOVE_EN_PASSANT));
-                    }          
-                }
-            } 
-            else
-            {
-                Bitboard pawns = _pieces[currentPlayer][0];
+            int from = move.from();
+            int to = move.to();
+            Bitboard88 fromBoard = u64a1 << from;
+            Bitboard88 toBoard = u64a1 << to;
 
-                Bitboard pawnsm = (pawns >> 8) & _notoccupied; 
-                Bitboard pawndm = (pawnsm >> 8) & _notoccupied & RANK_5;
+            if(!(_pieces[Us][6] & fromBoard).has() || (_pieces[Us][6] & toBoard).has())
+                return false;
 
-                //Gen pawn promotions
-                Bitboard pawnpromo = pawnsm & RANK_1;
-                pawnsm &= ~RANK_1;
+            U8 type = pieceTypeOn(from);
+            bool capture = (_pieces[them][6] & toBoard).has();
+            //Flag without the promotion piece
+            U8 flag = move.isPromotion() ? (move.flag() & ~3) : move.flag();
 
-                Bitboard pawnlc = (pawns >> 7) & otherPieces & ~BFILE_A & ~RANK_1;
-                Bitboard pawnrc = (pawns >> 9) & otherPieces & ~BFILE_H & ~RANK_1;
+            #pragma region Castling
+            if(move.isKingSideCastling() || move.isQueenSideCastling())
+            {
+                const int home = Color::home;
+                bool kingSide = move.isKingSideCastling();
+                int rook = kingSide ? home + 7 : home;
+
+                if(type != STANDARD_PT_KING || from != home + 4 || to != (kingSide ? home + 6 : home + 2))
+                    return false;
+                if(!(state().castlingRights & (kingSide ? Color::kingSideCastling : Color::queenSideCastling)) || !_pieces[Us][STANDARD_PT_ROOK].get(rook))
+                    return false;
+                if((between88[from][rook] & _occupied).has() || state().checkers.has())
+                    return false;
+
+                //The king crosses and lands on two squares
+                int step = kingSide ? 1 : -1;
+                return !_squareIsUnderAttack<Us,Backend>(from + step,_occupied) && !_squareIsUnderAttack<Us,Backend>(from + 2 * step,_occupied);
+            }
+            #pragma endregion
 
-                Bitboard pawnlcpromo = (pawns >> 7) & otherPieces & ~BFILE_A & RANK_1;
-                Bitboard pawnrcpromo = (pawns >> 9) & otherPieces & ~BFILE_H & RANK_1;
+            #pragma region Reach
+            if(type == STANDARD_PT_PAWN)
+            {
+                Bitboard88 captures = Color::pawnAttacks(fromBoard);
 
-                while (pawnsm.has())
+                if(flag == MOVE_EN_PASSANT)
                 {
-                    unsigned int pos = pawnsm.bitScanPopNext();
-                    moves.push_back(Move(pos + 8,pos,STANDARD_PT_PAWN,MOVE_VALID));
+                    if(to != state().enpassant || !(captures & toBoard).has())
+                        return false;
                 }
-                
-                while (pawndm.has())
+                else if(flag == MOVE_CAPTURE || flag == MOVE_PROMOTION_CAPTURE)
                 {
-                    unsigned int pos = pawndm.bitScanPopNext();
-                    moves.push_back(Move(pos + 16,pos,STANDARD_PT_PAWN,MOVE_DOUBLE_PAWN));
+                    if(!capture || !(captures & toBoard).has())
+                        return false;
                 }
-
-                while (pawnlc.has())
+                else if(flag == MOVE_DOUBLE_PAWN)
                 {
-                    unsigned int pos = pawnlc.bitScanPopNext();
-
-                    Move m(pos + 7,pos,STANDARD_PT_PAWN,MOVE_CAPTURE);
-                    moves.push_back(m);
+                    if(to != from + 2 * Color::up || !(toBoard & Color::doublePushRank).has() || _occupied.get(from + Color::up) || _occupied.get(to))
+                        return false;
                 }
-
-                while (pawnrc.has())
+                else if(flag == MOVE_QUIET || flag == MOVE_PROMOTION)
                 {
-                    unsigned int pos = pawnrc.bitScanPopNext();
-
-                    Move m(pos + 9,pos,STANDARD_PT_PAWN,MOVE_CAPTURE);
-                    moves.push_back(m);
+                    if(to != from + Color::up || _occupied.get(to))
+                        return false;
                 }
+                else
+                    return false;
 
-                //Promotions
-                while (pawnpromo.has())
-                {
-                    unsigned int pos = pawnpromo.bitScanPopNext();
-                    Move mva(pos + 8,pos,STANDARD_PT_PAWN,MOVE_PROMOTION);
-                    mva.promotionpiecetype = STANDARD_PT_ROOK;
-                    moves.push_back(mva);
-
-                    Move mvb(pos + 8,pos,STANDARD_PT_PAWN,MOVE_PROMOTION);
-                    mvb.promotionpiecetype = STANDARD_PT_QUEEN;
-                    moves.push_back(mvb);
-
-                    Move mvc(pos + 8,pos,STANDARD_PT_PAWN,MOVE_PROMOTION);
-                    mvc.promotionpiecetype = STANDARD_PT_BISHOP;
-                    moves.push_back(mvc);
-
-                    Move mvd(pos + 8,pos,STANDARD_PT_PAWN,MOVE_PROMOTION);
-                    mvd.promotionpiecetype = STANDARD_PT_KNIGHT;
-                    moves.push_back(mvd);
-                }
+                //Promotion flag exactly on the last rank
+                if(move.isPromotion() != (toBoard & Color::promotionRank).has())
+                    return false;
+            }
+            else
+            {
+                if(flag != (capture ? MOVE_CAPTURE : MOVE_QUIET))
+                    return false;
+
+                Bitboard88 reach;
+                if(type == STANDARD_PT_KNIGHT)
+                    reach = knight88[from];
+                else if(type == STANDARD_PT_KING)
+                    reach = border88[from];
+                else if(type == STANDARD_PT_ROOK)
+                    reach = rookAttacks<Backend>(from,_occupied);
+                else if(type == STANDARD_PT_BISHOP)
+                    reach = bishopAttacks<Backend>(from,_occupied);
+                else
+                    reach = queenAttacks<Backend>(from,_occupied);
 
+                if(!(reach & toBoard).has())
+                    return false;
+            }
+            #pragma endregion
 
-                while (pawnrcpromo.has())
-                {
-                    unsigned int pos = pawnrcpromo.bitScanPopNext();
+            #pragma region King safety
+            //Occupancy after the move, captured pieces no longer attack
+            Bitboard88 occupied = (_occupied ^ fromBoard) | toBoard;
+            Bitboard88 removed = toBoard;
 
-                    Move m(pos + 9,pos,STANDARD_PT_PAWN,MOVE_CAPTURE | MOVE_PROMOTION);
-                    m.promotionpiecetype = STANDARD_PT_ROOK;
-                    moves.push_back(m);
+            if(flag == MOVE_EN_PASSANT)
+            {
+                Bitboard88 captured = u64a1 << (to - Color::up);
+                occupied ^= captured;
+                removed |= captured;
+            }
 
-                    Move mb(pos + 9,pos,STANDARD_PT_PAWN,MOVE_CAPTURE | MOVE_PROMOTION);
-                    mb.promotionpiecetype = STANDARD_PT_KNIGHT;
-                    moves.push_back(mb);
+            int king = type == STANDARD_PT_KING ? to : _pieces[Us][STANDARD_PT_KING].bitScanForward();
+            if(king == -1)
+                return true;
 
-                    Move mc(pos + 9,pos,STANDARD_PT_PAWN,MOVE_CAPTURE | MOVE_PROMOTION);
-                    mc.promotionpiecetype = STANDARD_PT_QUEEN;
-                    moves.push_back(mc);
+            return !(_allAttackersTo<Backend>(king,occupied) & _pieces[them][6] & ~removed).has();
+            #pragma endregion
+        }
 
-                    Move md(pos + 9,pos,STANDARD_PT_PAWN,MOVE_CAPTURE | MOVE_PROMOTION);
-                    md.promotionpiecetype = STANDARD_PT_BISHOP;
-                    moves.push_back(md);
-                }
+        //Generate all king moves
+        template <U8 Us>
+        void genKingMoves(MoveList &list)
+        {   
+            int pos = kingSquare;
 
-                while (pawnlcpromo.has())
-                {
-                    unsigned int pos = pawnlcpromo.bitScanPopNext();
+            if(pos == -1 || !sourceMask.get(pos))
+                return;
 
-                    Move m(pos + 7,pos,STANDARD_PT_PAWN,MOVE_CAPTURE | MOVE_PROMOTION);
-                    m.promotionpiecetype = STANDARD_PT_ROOK;
-                    moves.push_back(m);
+            //Attacked squares already see through the king
+            _genPieceMoves(list,pos,border88[pos] & targetMask & ~attackedSquares);
 
-                    Move mb(pos + 7,pos,STANDARD_PT_PAWN,MOVE_CAPTURE | MOVE_PROMOTION);
-                    mb.promotionpiecetype = STANDARD_PT_KNIGHT;
-                    moves.push_back(mb);
+            //Castlings (Not while in check, path empty, king path not attacked)
+            const int home = StandardColor<Us>::home;
 
-                    Move mc(pos + 7,pos,STANDARD_PT_PAWN,MOVE_CAPTURE | MOVE_PROMOTION);
-                    mc.promotionpiecetype = STANDARD_PT_QUEEN;
-                    moves.push_back(mc);
+            if(!(genType & GEN_QUIETS) || checkers.has() || pos != home + 4)
+                return;
 
-                    Move md(pos + 7,pos,STANDARD_PT_PAWN,MOVE_CAPTURE | MOVE_PROMOTION);
-                    md.promotionpiecetype = STANDARD_PT_BISHOP;
-                    moves.push_back(md);
-                }
+            Bitboard88 rooks = _pieces[Us][STANDARD_PT_ROOK];
 
-                if(enpassant != -1)
-                {
-                    Bitboard enpa = ((u64a1 << enpassant));
+            U8 rights = state().castlingRights;
 
-                    while(pawns.has())
-                    {
-                        unsigned int pos = pawns.bitScanPopNext();
-                        Bitboard pawn = u64a1 << pos;
-                        Bitboard bothcaptures = ((pawn >> 7) & ~BFILE_A) | ((pawn >> 9) & ~BFILE_H);
+            if((rights & StandardColor<Us>::kingSideCastling) && rooks.get(home + 7))
+                if(!(between88[pos][home + 7] & _occupied).has() && !(between88[pos][home + 7] & attackedSquares).has())
+                    list.push_back(Move(pos,pos + 2,MOVE_KING_SIDE_CASTLING));
 
-                        if((bothcaptures & enpa).has())
-                            moves.push_back(Move(pos,enpassant,STANDARD_PT_PAWN,MOVE_EN_PASSANT));
-                    }          
-                }
-            }  
+            if((rights & StandardColor<Us>::queenSideCastling) && rooks.get(home))
+                if(!(between88[pos][home] & _occupied).has() && !(between88[pos][pos - 3] & attackedSquares).has())
+                    list.push_back(Move(pos,pos - 2,MOVE_QUEEN_SIDE_CASTLING));
         }
 
-        //Generate all rook moves
-        void genRooksMoves()
+        //Generate all pawn moves
+        template <U8 Us,SliderBackend Backend>
+        void genPawnMoves(MoveList &list)
         {
-            Bitboard pieces = (_pieces[currentPlayer][STANDARD_PT_ROOK]);
+            Bitboard88 pawns = _pieces[Us][STANDARD_PT_PAWN] & sourceMask;
 
-            while (pieces.has())
-            {
-                unsigned int pos = pieces.bitScanPopNext();
-                
-                //All moves
-                Bitboard all = genRayMoves(pos,NORTH,currentPlayer,false) | genRayMoves(pos,SOUTH,currentPlayer,true) | genRayMoves(pos,EAST,currentPlayer,false) | genRayMoves(pos,WEST,currentPlayer,true);
-                
-                //Captures
-                Bitboard captures = all & otherPieces;
-                
-                //No captures
-                Bitboard nocaptures = all & ~captures;
+            //Free pawns move together, pinned pawns only along their pin line
+            _genPawnMoves<Us>(list,pawns & ~pinned,checkMask);
 
-                while (nocaptures.has())
-                    moves.push_back(Move(pos,nocaptures.bitScanPopNext(),STANDARD_PT_ROOK,MOVE_VALID));
-                while (captures.has())
-                {
-                    int cpos = captures.bitScanPopNext();
+            for (int pos : pawns & pinned)
+                _genPawnMoves<Us>(list,Bitboard88(u64a1 << pos),checkMask & line88[kingSquare][pos]);
 
-                    Move m = Move(pos,cpos,STANDARD_PT_ROOK,MOVE_CAPTURE);
-                    moves.push_back(m);
-                }
-            }
+            if(state().enpassant != -1 && (genType & GEN_CAPTURES))
+                _genEnPassant<Us,Backend>(list,pawns);
         }
 
-        //Generate all bishop moves
-        void genBishopMoves()
+        //Generate pawn pushes, captures and promotions landing on the mask (Promotions are generated with the captures)
+        template <U8 Us>
+        void _genPawnMoves(MoveList &list,Bitboard88 pawns,Bitboard88 mask)
         {
-            Bitboard pieces = (_pieces[currentPlayer][STANDARD_PT_BISHOP]);
+            typedef StandardColor<Us> Color;
+
+            //Pawn single moves
+            Bitboard88 pawnsm = _shift88<Color::up>(pawns) & _notoccupied;
+            Bitboard88 pawndm = _shift88<Color::up>(pawnsm) & _notoccupied & Color::doublePushRank & mask;
+            pawnsm &= mask;
 
-            while (pieces.has())
+            //Gen pawn promotions
+            Bitboard88 pawnpromo = pawnsm & Color::promotionRank;
+            pawnsm &= ~Color::promotionRank;
+
+            if(genType & GEN_QUIETS)
             {
-                unsigned int pos = pieces.bitScanPopNext();
-                
-                //All moves
-                Bitboard all = genRayMoves(pos,NORTH_EAST,currentPlayer,false) | genRayMoves(pos,SOUTH_EAST,currentPlayer,true) | genRayMoves(pos,NORTH_WEST,currentPlayer,false) | genRayMoves(pos,SOUTH_WEST,currentPlayer,true);
-                
-                //Captures
-                Bitboard captures = all & otherPieces;
-                
-                //No captures
-                Bitboard nocaptures = all & ~captures;
+                for (int pos : pawnsm)
+                    list.push_back(Move(pos - Color::up,pos,MOVE_QUIET));
 
-                while (nocaptures.has())
-                    moves.push_back(Move(pos,nocaptures.bitScanPopNext(),STANDARD_PT_BISHOP,MOVE_VALID));
-                while (captures.has())
-                {
-                    int cpos = captures.bitScanPopNext();
+                for (int pos : pawndm)
+                    list.push_back(Move(pos - 2 * Color::up,pos,MOVE_DOUBLE_PAWN));
+            }
+
+            if(!(genType & GEN_CAPTURES))
+                return;
+
+            //Captures towards file A and towards file H
+            Bitboard88 pawnwc = _shift88<Color::westCapture>(pawns) & ~BFILE_H & otherPieces & mask;
+            Bitboard88 pawnec = _shift88<Color::eastCapture>(pawns) & ~BFILE_A & otherPieces & mask;
+
+            for (int pos : pawnwc & ~Color::promotionRank)
+                list.push_back(Move(pos - Color::westCapture,pos,MOVE_CAPTURE));
+
+            for (int pos : pawnec & ~Color::promotionRank)
+                list.push_back(Move(pos - Color::eastCapture,pos,MOVE_CAPTURE));
+
+            //Promotions
+            for (int pos : pawnpromo)
+                _addPromotions(list,pos - Color::up,pos,MOVE_PROMOTION);
+
+            for (int pos : pawnwc & Color::promotionRank)
+                _addPromotions(list,pos - Color::westCapture,pos,MOVE_PROMOTION_CAPTURE);
 
-                    Move m = Move(pos,cpos,STANDARD_PT_BISHOP,MOVE_CAPTURE);
-                    moves.push_back(m);
+            for (int pos : pawnec & Color::promotionRank)
+                _addPromotions(list,pos - Color::eastCapture,pos,MOVE_PROMOTION_CAPTURE);
+        }
+
+        //Generate en passant captures (Two pieces leave the same rank, checked against the sliders directly)
+        template <U8 Us,SliderBackend Backend>
+        void _genEnPassant(MoveList &list,Bitboard88 pawns)
+        {
+            const U8 them = StandardColor<Us>::them;
+            int enpassant = state().enpassant;
+            Bitboard88 enpa = u64a1 << enpassant;
+            int capturedpos = enpassant - StandardColor<Us>::up;
+            Bitboard88 attackers = StandardColor<them>::pawnAttacks(enpa);
+
+            Bitboard88 rooks = _pieces[them][STANDARD_PT_ROOK] | _pieces[them][STANDARD_PT_QUEEN];
+            Bitboard88 bishops = _pieces[them][STANDARD_PT_BISHOP] | _pieces[them][STANDARD_PT_QUEEN];
+
+            for (int pos : attackers & pawns)
+            {
+                //Without a king there is nothing to uncover
+                if(kingSquare == -1)
+                {
+                    list.push_back(Move(pos,enpassant,MOVE_EN_PASSANT));
+                    continue;
                 }
+
+                Bitboard88 occupied = (_occupied ^ Bitboard88(u64a1 << pos) ^ Bitboard88(u64a1 << capturedpos)) | enpa;
+
+                if((rookAttacks<Backend>(kingSquare,occupied) & rooks).has())
+                    continue;
+                if((bishopAttacks<Backend>(kingSquare,occupied) & bishops).has())
+                    continue;
+                //Checked by a piece other than the captured pawn
+                if((checkers & ~Bitboard88(u64a1 << capturedpos) & ~(rooks | bishops)).has())
+                    continue;
+
+                list.push_back(Move(pos,enpassant,MOVE_EN_PASSANT));
             }
         }
 
-        //Generate all queen moves
-        void genQueenMoves()
+        //Generate all rook moves
+        template <U8 Us,SliderBackend Backend>
+        void genRooksMoves(MoveList &list)
         {
-            Bitboard pieces = (_pieces[currentPlayer][STANDARD_PT_QUEEN]);
+            Bitboard88 pieces = (_pieces[Us][STANDARD_PT_ROOK]) & sourceMask;
 
-            while (pieces.has())
+            for (int pos : pieces)
             {
-                unsigned int pos = pieces.bitScanPopNext();
-                
                 //All moves
-                Bitboard all = genRayMoves(pos,NORTH,currentPlayer,false) | genRayMoves(pos,SOUTH,currentPlayer,true) | genRayMoves(pos,EAST,currentPlayer,false) | genRayMoves(pos,WEST,currentPlayer,true) | genRayMoves(pos,NORTH_EAST,currentPlayer,false) | genRayMoves(pos,SOUTH_EAST,currentPlayer,true) | genRayMoves(pos,NORTH_WEST,currentPlayer,false) | genRayMoves(pos,SOUTH_WEST,currentPlayer,true);
-                
-                //Captures
-                Bitboard captures = all & otherPieces;
+                Bitboard88 all = rookAttacks<Backend>(pos,_occupied) & targetMask;
+
+                if(pinned.get(pos))
+                    all &= line88[kingSquare][pos];
                 
-                //No captures
-                Bitboard nocaptures = all & ~captures;
+                _genPieceMoves(list,pos,all);
+            }
+        }
 
-                while (nocaptures.has())
-                    moves.push_back(Move(pos,nocaptures.bitScanPopNext(),STANDARD_PT_QUEEN,MOVE_VALID));
-                while (captures.has())
-                {
-                    int cpos = captures.bitScanPopNext();
+        //Generate all bishop moves
+        template <U8 Us,SliderBackend Backend>
+        void genBishopMoves(MoveList &list)
+        {
+            Bitboard88 pieces = (_pieces[Us][STANDARD_PT_BISHOP]) & sourceMask;
 
-                    Move m = Move(pos,cpos,STANDARD_PT_QUEEN,MOVE_CAPTURE);
-                    moves.push_back(m);
-                }
+            for (int pos : pieces)
+            {
+                //All moves
+                Bitboard88 all = bishopAttacks<Backend>(pos,_occupied) & targetMask;
+
+                if(pinned.get(pos))
+                    all &= line88[kingSquare][pos];
+                
+                _genPieceMoves(list,pos,all);
             }
         }
 
-        //Generate all knight moves
-        void genKnightMoves()
+        //Generate all queen moves
+        template <U8 Us,SliderBackend Backend>
+        void genQueenMoves(MoveList &list)
         {
-            Bitboard pieces = (_pieces[currentPlayer][STANDARD_PT_KNIGHT]);
+            Bitboard88 pieces = (_pieces[Us][STANDARD_PT_QUEEN]) & sourceMask;
 
-            while (pieces.has())
+            for (int pos : pieces)
             {
-                unsigned int pos = pieces.bitScanPopNext();
-                Bitboard all = knight88[pos];
-                all &= playerPiecesInverse;
-                
-                //Captures
-                Bitboard captures = all & otherPieces;
+                //All moves
+                Bitboard88 all = queenAttacks<Backend>(pos,_occupied) & targetMask;
+
+                if(pinned.get(pos))
+                    all &= line88[kingSquare][pos];
                 
-                //No captures
-                Bitboard nocaptures = all & ~captures;
+                _genPieceMoves(list,pos,all);
+            }
+        }
 
-                while (nocaptures.has())
-                    moves.push_back(Move(pos,nocaptures.bitScanPopNext(),STANDARD_PT_KNIGHT,MOVE_VALID));
-                while (captures.has())
-                {
-                    int cpos = captures.bitScanPopNext();
+        //Generate all knight moves (A pinned knight never moves)
+        template <U8 Us>
+        void genKnightMoves(MoveList &list)
+        {
+            Bitboard88 pieces = (_pieces[Us][STANDARD_PT_KNIGHT]) & sourceMask & ~pinned;
 
-                    Move m = Move(pos,cpos,STANDARD_PT_KNIGHT,MOVE_CAPTURE);
-                    moves.push_back(m);
-                }
-            }
+            for (int pos : pieces)
+                _genPieceMoves(list,pos,knight88[pos] & targetMask);
         }
 
-        //Generate move rays
-        Bitboard genRayMoves(int pos,Direction direction,U8 player,bool reverse)
+        //Split destinations into captures and quiet moves
+        void _genPieceMoves(MoveList &list,int pos,Bitboard88 all)
         {
-            Bitboard ray = rays88[direction][pos];
-            //Get blocker
-            int blockindex = reverse ? (ray & _occupied).bitScanReverse() : (ray & _occupied).bitScanForward();
-            if(blockindex >= 0)
-                ray &= ~rays88[direction][blockindex];
-
-            //Remove player piece
-            ray &= ~_pieces[player][6];
-            return ray;
+            //Captures
+            Bitboard88 captures = all & otherPieces;
+            
+            //No captures
+            Bitboard88 nocaptures = all & ~captures;
+
+            for (int to : nocaptures)
+                list.push_back(Move(pos,to,MOVE_QUIET));
+            for (int cpos : captures)
+                list.push_back(Move(pos,cpos,MOVE_CAPTURE));
         }
+
         #pragma endregion
 
         /**
          * MARKER Attacks Utils
          */
         #pragma region
-        void genAttacks(Bitboard targetsSquares,Bitboard targetPieces,int targetsquare,U8 player)
+        //All squares attacked by a player (Sliders see through the target pieces)
+        template <U8 Them,SliderBackend Backend>
+        void genAttacks(Bitboard88 targetPieces)
         {
             //Get all attacked squares
             attackedSquares.clear();
-            attackBlockers.clear();
 
-            //Clear attacks
-            directAttackLines.clear();
-            blockedAttackLines.clear();
-            captureAttackingPieces.clear();
+            Bitboard88 xrayOccupied = _occupied & ~targetPieces;
 
             //Rooks
             {
-                Bitboard pieces = (_pieces[player][STANDARD_PT_ROOK]);
+                Bitboard88 pieces = (_pieces[Them][STANDARD_PT_ROOK]);
 
-                while (pieces.has())
-                {
-                    unsigned int pos = pieces.bitScanPopNext();
-
-                    genAttackRay(pos,SOUTH,player,true,targetsquare,targetsSquares,targetPieces,attackedSquares,attackBlockers);
-                    genAttackRay(pos,WEST,player,true,targetsquare,targetsSquares,targetPieces,attackedSquares,attackBlockers);
-                    genAttackRay(pos,EAST,player,false,targetsquare,targetsSquares,targetPieces,attackedSquares,attackBlockers);
-                    genAttackRay(pos,NORTH,player,false,targetsquare,targetsSquares,targetPieces,attackedSquares,attackBlockers);
-                }
+                for (int pos : pieces)
+                    attackedSquares |= rookAttacks<Backend>(pos,xrayOccupied);
             }
 
             //Bishop
             {
-                Bitboard pieces = (_pieces[player][STANDARD_PT_BISHOP]);
-
-                while (pieces.has())
-                {
-                    unsigned int pos = pieces.bitScanPopNext();
+                Bitboard88 pieces = (_pieces[Them][STANDARD_PT_BISHOP]);
 
-                    genAttackRay(pos,SOUTH_EAST,player,true,targetsquare,targetsSquares,targetPieces,attackedSquares,attackBlockers);
-                    genAttackRay(pos,SOUTH_WEST,player,true,targetsquare,targetsSquares,targetPieces,attackedSquares,attackBlockers);
-                    genAttackRay(pos,NORTH_EAST,player,false,targetsquare,targetsSquares,targetPieces,attackedSquares,attackBlockers);
-                    genAttackRay(pos,NORTH_WEST,player,false,targetsquare,targetsSquares,targetPieces,attackedSquares,attackBlockers);
-                }
+                for (int pos : pieces)
+                    attackedSquares |= bishopAttacks<Backend>(pos,xrayOccupied);
             }
 
             //Queen
             {
-                Bitboard pieces = (_pieces[player][STANDARD_PT_QUEEN]);
+                Bitboard88 pieces = (_pieces[Them][STANDARD_PT_QUEEN]);
 
-                while (pieces.has())
-                {
-                    unsigned int pos = pieces.bitScanPopNext();
-
-                    genAttackRay(pos,SOUTH,player,true,targetsquare,targetsSquares,targetPieces,attackedSquares,attackBlockers);
-                    genAttackRay(pos,WEST,player,true,targetsquare,targetsSquares,targetPieces,attackedSquares,attackBlockers);
-                    genAttackRay(pos,EAST,player,false,targetsquare,targetsSquares,targetPieces,attackedSquares,attackBlockers);
-                    genAttackRay(pos,NORTH,player,false,targetsquare,targetsSquares,targetPieces,attackedSquares,attackBlockers);
-                    genAttackRay(pos,SOUTH_EAST,player,true,targetsquare,targetsSquares,targetPieces,attackedSquares,attackBlockers);
-                    genAttackRay(pos,SOUTH_WEST,player,true,targetsquare,targetsSquares,targetPieces,attackedSquares,attackBlockers);
-                    genAttackRay(pos,NORTH_EAST,player,false,targetsquare,targetsSquares,targetPieces,attackedSquares,attackBlockers);
-                    genAttackRay(pos,NORTH_WEST,player,false,targetsquare,targetsSquares,targetPieces,attackedSquares,attackBlockers);
-                    
-                }
+                for (int pos : pieces)
+                    attackedSquares |= queenAttacks<Backend>(pos,xrayOccupied);
             }
 
             //King
             {
-                Bitboard pieces = (_pieces[player][STANDARD_PT_KING]);
+                Bitboard88 pieces = (_pieces[Them][STANDARD_PT_KING]);
 
-                while (pieces.has())
-                {
-                    unsigned int pos = pieces.bitScanPopNext();
+                for (int pos : pieces)
                     attackedSquares |= border88[pos];
-
-                    if((border88[pos] & targetPieces).has())
-                        captureAttackingPieces |= u64a1 << pos;
-                }
             }
 
             //Knight
             {
-                Bitboard pieces = (_pieces[player][STANDARD_PT_KNIGHT]);
+                Bitboard88 pieces = (_pieces[Them][STANDARD_PT_KNIGHT]);
 
-                while (pieces.has())
-                {
-                    unsigned int pos = pieces.bitScanPopNext();
+                for (int pos : pieces)
                     attackedSquares |= knight88[pos];
-
-                    if((knight88[pos] & targetPieces).has())
-                        captureAttackingPieces |= u64a1 << pos;
-                }
             }
 
             //Pawn attacks
-            {
-                Bitboard pawns = (_pieces[player][STANDARD_PT_PAWN]);
+            attackedSquares |= StandardColor<Them>::pawnAttacks(_pieces[Them][STANDARD_PT_PAWN]);
+        }
 
-                if(player == 0)
-                {
-                    Bitboard b = ((pawns << 7) & ~BFILE_H);
-                    Bitboard a = ((pawns << 9) & ~BFILE_A);
+        //Find the pieces pinned to the king of the current player
+        template <U8 Us,SliderBackend Backend>
+        void genCheckInfo()
+        {
+            const U8 them = StandardColor<Us>::them;
 
-                    attackedSquares |= b | a;
+            //Checkers were found when the move was made
+            checkers = state().checkers;
+            pinned.clear();
 
-                    if((b & targetPieces).has())
-                        captureAttackingPieces |= (b & targetPieces) >> 7;
-                    if((a & targetPieces).has())
-                        captureAttackingPieces |= (a & targetPieces) >> 9;
-                }
-                else
-                {
-                    Bitboard b = ((pawns >> 7) & ~BFILE_A);
-                    Bitboard a = ((pawns >> 9) & ~BFILE_H);
+            if(kingSquare == -1)
+                return;
 
-                    attackedSquares |= b | a;
+            Bitboard88 rooks = _pieces[them][STANDARD_PT_ROOK] | _pieces[them][STANDARD_PT_QUEEN];
+            Bitboard88 bishops = _pieces[them][STANDARD_PT_BISHOP] | _pieces[them][STANDARD_PT_QUEEN];
 
-                    if((b & targetPieces).has())
-                        captureAttackingPieces |= (b & targetPieces) << 7;
-                    if((a & targetPieces).has())
-                        captureAttackingPieces |= (a & targetPieces) << 9;
-                }
+            //Sliders aligned with the king on an empty board, one piece between means a pin
+            Bitboard88 snipers = (rookAttacks<Backend>(kingSquare,Bitboard88()) & rooks) | (bishopAttacks<Backend>(kingSquare,Bitboard88()) & bishops);
+
+            for (int pos : snipers)
+            {
+                Bitboard88 blockers = between88[kingSquare][pos] & _occupied;
+
+                if(blockers.popCount() == 1)
+                    pinned |= blockers & _pieces[Us][6];
             }
         }
+        #pragma endregion
 
-        void genAttackRay(int pos,Direction direction,U8 player,bool reverse,int targetsquare,Bitboard &targetsSquares,Bitboard &targetPieces,Bitboard &squares,Bitboard &blockers)
+        /**
+         * MARKER State utils
+         */
+        #pragma region
+        StandardStateInfo &state()
         {
-            //Create next
-            Bitboard ray = rays88[direction][pos];
+            return _states[_stateIndex];
+        }
 
-            if((ray & (targetPieces)).has())
-            {
-                //Targeting piece
-                int blockindex = reverse ? (ray & targetPieces).bitScanReverse() : (ray & targetPieces).bitScanForward();
-                int blockindexafter = reverse ? (ray & _occupied & (~targetPieces)).bitScanReverse() : (ray & _occupied & (~targetPieces)).bitScanForward();
-                
-                Bitboard b = ray & (~rays88[direction][blockindex]);
+        const StandardStateInfo &state() const
+        {
+            return _states[_stateIndex];
+        }
 
-                if(blockindexafter != -1)
-                    squares |= (ray & (~rays88[direction][blockindexafter]));
-                else
-                    squares |= ray;
+        //Position key from scratch (Pieces, side to move, castling rights, en passant file)
+        U64 computeKey() const
+        {
+            U64 key = 0;
 
-                if(blockindexafter == -1 || (reverse ? (blockindex > blockindexafter) : (blockindex < blockindexafter)))
-                {
-                    captureAttackingPieces |= u64a1 << pos;
-                    //Add direct attacking lines
-                    directAttackLines.push_back(AttackLine((rays88[direction][pos] & ~rays88[direction][targetsquare]) | Bitboard(u64a1 << pos),blockindex));
-                }
-                else if((b & _occupied).popCount() == 2)
-                {
-                    blockers |= u64a1 << blockindexafter;
-                    //Defended
-                    blockedAttackLines.push_back(AttackLine((rays88[direction][pos] & ~rays88[direction][targetsquare]) | Bitboard(u64a1 << pos),blockindex));
-                }
-                
+            for (int pos = 0; pos < 64; pos ++)
+                if(_mailbox[pos] != NO_PIECE)
+                    key ^= ZOBRIST.pieces[playerOn(pos)][pieceTypeOn(pos)][pos];
+
+            if(currentPlayer == STANDARD_PLAYER_BLACK)
+                key ^= ZOBRIST.side;
+
+            key ^= ZOBRIST.castling[state().castlingRights];
+
+            if(state().enpassant != -1)
+                key ^= ZOBRIST.enpassant[state().enpassant % 8];
+
+            return key;
+        }
+
+        //Debug verifier, the incremental key must match a full recomputation
+        bool verifyKey() const
+        {
+            return state().key == computeKey();
+        }
+
+        void _checkKey(const char *where) const
+        {
+            if(!verifyKey())
+            {
+                printf("Zobrist key mismatch after %s\n",where);
+                abort();
             }
-            else
+        }
+
+        //Recompute the checkers of the current state (After editing the board directly)
+        void _updateCheckers()
+        {
+            int king = _pieces[currentPlayer][STANDARD_PT_KING].bitScanForward();
+
+            if(king == -1)
+                state().checkers.clear();
+            else if(sliderBackend == SLIDER_PEXT)
             {
-                int blockindex = reverse ? (ray & _occupied).bitScanReverse() : (ray & _occupied).bitScanForward();
-                if(blockindex > -1)            
-                    squares |= ray & (~rays88[direction][blockindex]);  
+                if(currentPlayer == STANDARD_PLAYER_WHITE)
+                    state().checkers = _attackersTo<STANDARD_PLAYER_BLACK,SLIDER_PEXT>(king);
                 else
-                    squares |= ray;                       
-            }  
+                    state().checkers = _attackersTo<STANDARD_PLAYER_WHITE,SLIDER_PEXT>(king);
+            }
+            else if(currentPlayer == STANDARD_PLAYER_WHITE)
+                state().checkers = _attackersTo<STANDARD_PLAYER_BLACK,SLIDER_MAGIC>(king);
+            else
+                state().checkers = _attackersTo<STANDARD_PLAYER_WHITE,SLIDER_MAGIC>(king);
         }
         #pragma endregion
 
@@ -1495,10 +1854,12 @@ class StandardBoard : public Board
         #pragma region 
         void _removePiece(U8 player, U8 piece, U8 pos) 
         {
-            Bitboard square = u64a1 << pos;
+            Bitboard88 square = u64a1 << pos;
 
             _pieces[player][piece] ^= square;
             _pieces[player][6] ^= square;
+            _mailbox[pos] = NO_PIECE;
+            state().key ^= ZOBRIST.pieces[player][piece][pos];
 
             _occupied ^= square;
             
@@ -1507,10 +1868,12 @@ class StandardBoard : public Board
 
         void _addPiece(U8 player, U8 piece, U8 pos) 
         {
-            Bitboard square = u64a1 << pos;
+            Bitboard88 square = u64a1 << pos;
 
             _pieces[player][piece] |= square;
             _pieces[player][6] |= square;
+            _mailbox[pos] = _mailboxPiece(player,piece);
+            state().key ^= ZOBRIST.pieces[player][piece][pos];
 
             _occupied |= square;
             _notoccupied = ~_occupied;
@@ -1518,10 +1881,13 @@ class StandardBoard : public Board
 
         void _movePiece(U8 player, U8 piece, U8 from, U8 to)
         {
-            Bitboard squareMask =  (u64a1 << to) | (u64a1 << from);
+            Bitboard88 squareMask =  (u64a1 << to) | (u64a1 << from);
 
             _pieces[player][piece] ^= squareMask;
             _pieces[player][6] ^= squareMask;
+            _mailbox[to] = _mailbox[from];
+            _mailbox[from] = NO_PIECE;
+            state().key ^= ZOBRIST.pieces[player][piece][from] ^ ZOBRIST.pieces[player][piece][to];
 
             _occupied ^= squareMask;
             _notoccupied = ~_occupied;
@@ -1534,28 +1900,30 @@ class StandardBoard : public Board
         #pragma region 
         void stringifyMove(Move move,std::string &output)
         {
-            char c = piecesChars[move.piecetype];
-            std::string s = c == 'P' ? (std::string() + posToInt(move.from)) : (std::string() + c + posToInt(move.from));
+            //Called after doMove, the moved piece already stands on the destination
+            U8 piecetype = move.isPromotion() ? STANDARD_PT_PAWN : getPiece(currentPlayer == 0 ? 1 : 0,move.to());
+            char c = piecesChars[piecetype];
+            std::string s = c == 'P' ? (std::string() + posToInt(move.from())) : (std::string() + c + posToInt(move.from()));
 
-            if(move.flag & MOVE_KING_SIDE_CASTLING)
+            if(move.isKingSideCastling())
             {
                 output = "O-O";
                 return;
             }
 
-            if(move.flag & MOVE_QUEEN_SIDE_CASTLING)
+            if(move.isQueenSideCastling())
             {
                 output = "O-O-O";
                 return;
             }
 
-            if(move.flag & MOVE_CAPTURE)
-                s += "x" + posToInt(move.to);
+            if(move.isCapture())
+                s += "x" + posToInt(move.to());
             else
-                s += posToInt(move.to);
+                s += posToInt(move.to());
             
-            if(move.flag & MOVE_PROMOTION)
-                s = s + "=" + piecesChars[move.promotionpiecetype];
+            if(move.isPromotion())
+                s = s + "=" + piecesChars[STANDARD_PROMOTIONS[move.promotion()]];
 
             if(playerIsInCheck(currentPlayer))
             {
@@ -1586,7 +1954,7 @@ class StandardBoard : public Board
                 genMoves();
                 for(auto move : legalMoves)
                 {
-                    if(move.flag & MOVE_QUEEN_SIDE_CASTLING)
+                    if(move.isQueenSideCastling())
                         return move;
                 }
 
@@ -1598,7 +1966,7 @@ class StandardBoard : public Board
                 genMoves();
                 for(auto move : legalMoves)
                 {
-                    if(move.flag & MOVE_KING_SIDE_CASTLING)
+                    if(move.isKingSideCastling())
                         return move;
                 }
 
@@ -1679,7 +2047,7 @@ class StandardBoard : public Board
 
                 char c = move.at(move.length() - 1);
 
-                switch (expected_type)
+                switch (c)
                 {
                     case 'B':
                         promotion_target = STANDARD_PT_BISHOP;
@@ -1828,7 +2196,7 @@ class StandardBoard : public Board
             }
 
             //Piece filter
-            Bitboard piece_filter = u64one;
+            Bitboard88 piece_filter = u64one;
             if(from_row != -1)
                 piece_filter &= RANKS[from_row];
             if(from_column != -1)
@@ -1843,11 +2211,12 @@ class StandardBoard : public Board
             //Moves
             for (auto move : legalMoves)
             {
-                if(move.piecetype == piecetypeid)
+                if(getPiece(currentPlayer,move.from()) == piecetypeid)
                 {
-                    if((piece_filter & Bitboard(u64a1 << move.from)).has())
+                    if((piece_filter & Bitboard88(u64a1 << move.from())).has())
                     {
-                        if(move.to == target_destination && move.promotionpiecetype == promotion_target)
+                        U8 promotion = move.isPromotion() ? STANDARD_PROMOTIONS[move.promotion()] : 255;
+                        if(move.to() == target_destination && promotion == promotion_target)
                         {
                             if(found)
                             {
@@ -1856,7 +2225,7 @@ class StandardBoard : public Board
                             }
 
                             //Check warnings
-                            if((move.flag & MOVE_CAPTURE) != expected_capture)
+                            if(move.isCapture() != expected_capture)
                             {
                                 if(expected_capture)
                                     status += "Warning: Expected capture not found in move\n";
@@ -0,0 +1,77 @@
+/**
+ * 2aCE (Árnilsen's Adaptable Chess Engine)
+ * Copyright (C) 2021 Árnilsen Arthur Castilho Lopes
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef ZOBRIST_H
+#define ZOBRIST_H
+
+/**
+ * MARKER Includes
+ */
+#pragma region
+#include "../defs.hpp"
+#pragma endregion
+
+/**
+ * MARKER Zobrist keys (Standard 8x8)
+ * 
+ * Random keys for pieces, side to move, castling rights and en passant file.
+ * Generated at compile time from a fixed seed, keys are the same on every build
+ */
+#pragma region
+//xorshift64* step
+constexpr U64 _zobristNext(U64 &state)
+{
+    state ^= state >> 12;
+    state ^= state << 25;
+    state ^= state >> 27;
+    return state * 2685821657736338717ULL;
+}
+
+struct ZobristKeys
+{
+    U64 pieces[2][6][64];
+    U64 side;
+    U64 castling[16];
+    U64 enpassant[8];
+
+    constexpr ZobristKeys() : pieces(), side(0), castling(), enpassant()
+    {
+        U64 state = 1070372ULL;
+
+        for (int player = 0; player < 2; player++)
+            for (int type = 0; type < 6; type++)
+                for (int square = 0; square < 64; square++)
+                    pieces[player][type][square] = _zobristNext(state);
+
+        side = _zobristNext(state);
+
+        //Castling keys are the xor of one key per right, so a single xor changes any combination
+        U64 rights[4] = {_zobristNext(state), _zobristNext(state), _zobristNext(state), _zobristNext(state)};
+        for (int mask = 0; mask < 16; mask++)
+            for (int i = 0; i < 4; i++)
+                if (mask & (1 << i))
+                    castling[mask] ^= rights[i];
+
+        for (int file = 0; file < 8; file++)
+            enpassant[file] = _zobristNext(state);
+    }
+};
+
+constexpr ZobristKeys ZOBRIST = ZobristKeys();
+#pragma endregion
+#endif
@@ -0,0 +1,293 @@
+/**
+ * 2aCE (Árnilsen's Adaptable Chess Engine)
+ * Copyright (C) 2021 Árnilsen Arthur Castilho Lopes
+
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TT_H
+#define TT_H
+
+/**
+ * MARKER Includes
+ */
+#pragma region
+#include <atomic>
+#include <cstddef>
+#include "defs.hpp"
+#include "intrinsics.hpp"
+#include "move.hpp"
+#pragma endregion
+
+/**
+ * MARKER Bound types
+ */
+#pragma region
+const U8 TT_BOUND_NONE = 0;
+const U8 TT_BOUND_UPPER = 1; //Fail low, score <= alpha
+const U8 TT_BOUND_LOWER = 2; //Fail high, score >= beta
+const U8 TT_BOUND_EXACT = TT_BOUND_UPPER | TT_BOUND_LOWER;
+
+const int TT_CLUSTER_SIZE = 4; //Entries per 64 byte cluster
+const int TT_AGE_MASK = 63; //6 bit search age
+const int TT_DEFAULT_MB = 16;
+#pragma endregion
+
+/**
+ * MARKER Unpacked entry
+ */
+#pragma region
+struct TTData
+{
+    Move move;
+    int score;
+    int eval;
+    int depth;
+    U8 bound;
+};
+#pragma endregion
+
+/**
+ * MARKER Transposition table entry (16 bytes)
+ * 
+ * Data bits 0-15: move, 16-31: score, 32-47: static eval, 48-55: depth, 56-57: bound, 58-63: age
+ * Stored key is key ^ data, a torn write from another thread fails the check and reads as a miss
+ */
+#pragma region
+struct TTEntry
+{
+    std::atomic<U64> check;
+    std::atomic<U64> data;
+
+    static U64 pack(Move move, int score, int eval, int depth, U8 bound, U8 age)
+    {
+        return (U64)move.data
+            | ((U64)(U16)(short)score << 16)
+            | ((U64)(U16)(short)eval << 32)
+            | ((U64)(U8)depth << 48)
+            | ((U64)bound << 56)
+            | ((U64)age << 58);
+    }
+
+    static TTData unpack(U64 data)
+    {
+        TTData out;
+        out.move.data = (U16)data;
+        out.score = (short)(U16)(data >> 16);
+        out.eval = (short)(U16)(data >> 32);
+        out.depth = (signed char)(U8)(data >> 48);
+        out.bound = (data >> 56) & 3;
+        return out;
+    }
+
+    static U8 depthOf(U64 data)
+    {
+        return (U8)(data >> 48);
+    }
+
+    static U8 ageOf(U64 data)
+    {
+        return (U8)(data >> 58);
+    }
+};
+
+//One cache line, a probe touches a single line
+struct alignas(64) TTCluster
+{
+    TTEntry entries[TT_CLUSTER_SIZE];
+};
+#pragma endregion
+
+/**
+ * MARKER Transposition table
+ * 
+ * Shared by all search threads without locks, entries are read and written with relaxed atomics
+ */
+#pragma region
+class TranspositionTable
+{
+public:
+    /**
+     * MARKER Fields
+     */
+    #pragma region
+    TTCluster *clusters;
+    size_t clusterCount;
+    U8 age;
+    #pragma endregion
+
+    /**
+     * MARKER Constructors
+     */
+    #pragma region
+    TranspositionTable(size_t mb = TT_DEFAULT_MB)
+    {
+        clusters = nullptr;
+        clusterCount = 0;
+        resize(mb);
+    }
+
+    ~TranspositionTable()
+    {
+        delete[] clusters;
+    }
+
+    TranspositionTable(const TranspositionTable &) = delete;
+    TranspositionTable &operator=(const TranspositionTable &) = delete;
+    #pragma endregion
+
+    /**
+     * MARKER Size and aging
+     */
+    #pragma region
+    //Largest power of two cluster count that fits in the given size (Not thread safe)
+    void resize(size_t mb)
+    {
+        size_t count = 1;
+        while(count * 2 * sizeof(TTCluster) <= mb * 1024 * 1024)
+            count *= 2;
+
+        if(count != clusterCount)
+        {
+            delete[] clusters;
+            clusters = new TTCluster[count];
+            clusterCount = count;
+        }
+
+        clear();
+    }
+
+    void clear()
+    {
+        for(size_t i = 0; i < clusterCount; i ++)
+            for(int j = 0; j < TT_CLUSTER_SIZE; j ++)
+            {
+                clusters[i].entries[j].check.store(0, std::memory_order_relaxed);
+                clusters[i].entries[j].data.store(0, std::memory_order_relaxed);
+            }
+
+        age = 0;
+    }
+
+    size_t sizeMB() const
+    {
+        return clusterCount * sizeof(TTCluster) / (1024 * 1024);
+    }
+
+    //Called once per search, older entries become preferred victims
+    void newSearch()
+    {
+        age = (age + 1) & TT_AGE_MASK;
+    }
+
+    //Permille of the first 1000 clusters used by the current search
+    int hashfull() const
+    {
+        int used = 0;
+        size_t samples = clusterCount < 1000 ? clusterCount : 1000;
+
+        for(size_t i = 0; i < samples; i ++)
+            for(int j = 0; j < TT_CLUSTER_SIZE; j ++)
+            {
+                U64 data = clusters[i].entries[j].data.load(std::memory_order_relaxed);
+                if(data != 0 && TTEntry::ageOf(data) == age)
+                    used ++;
+            }
+
+        return (int)(used * 1000 / (samples * TT_CLUSTER_SIZE));
+    }
+    #pragma endregion
+
+    /**
+     * MARKER Probe and store
+     */
+    #pragma region
+    inline TTCluster &cluster(U64 key) const
+    {
+        return clusters[key & (clusterCount - 1)];
+    }
+
+    inline void prefetch(U64 key) const
+    {
+        _prefetch(&cluster(key));
+    }
+
+    bool probe(U64 key, TTData &out) const
+    {
+        TTCluster &c = cluster(key);
+
+        for(int i = 0; i < TT_CLUSTER_SIZE; i ++)
+        {
+            U64 data = c.entries[i].data.load(std::memory_order_relaxed);
+            U64 check = c.entries[i].check.load(std::memory_order_relaxed);
+
+            if(data != 0 && (check ^ data) == key)
+            {
+                out = TTEntry::unpack(data);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    //Same key is overwritten in place, otherwise the shallowest/oldest entry of the cluster
+    void store(U64 key, Move move, int score, int eval, int depth, U8 bound)
+    {
+        TTCluster &c = cluster(key);
+        TTEntry *victim = &c.entries[0];
+        int victimValue = 1 << 30;
+
+        for(int i = 0; i < TT_CLUSTER_SIZE; i ++)
+        {
+            TTEntry &entry = c.entries[i];
+            U64 data = entry.data.load(std::memory_order_relaxed);
+            U64 check = entry.check.load(std::memory_order_relaxed);
+
+            if(data == 0 || (check ^ data) == key)
+            {
+                if(data != 0)
+                {
+                    TTData old = TTEntry::unpack(data);
+
+                    //Keep a deeper result of the current search unless the new one is exact
+                    if(bound != TT_BOUND_EXACT && TTEntry::ageOf(data) == age && old.depth > depth + 2)
+                        return;
+
+                    //Keep the old best move when the new result has none
+                    if(!move.isValid())
+                        move = old.move;
+                }
+
+                victim = &entry;
+                break;
+            }
+
+            //Every search of age distance counts as 8 plies of depth
+            int value = (signed char)TTEntry::depthOf(data) - 8 * ((age - TTEntry::ageOf(data)) & TT_AGE_MASK);
+            if(value < victimValue)
+            {
+                victimValue = value;
+                victim = &entry;
+            }
+        }
+
+        U64 data = TTEntry::pack(move, score, eval, depth, bound, age);
+        victim->data.store(data, std::memory_order_relaxed);
+        victim->check.store(key ^ data, std::memory_order_relaxed);
+    }
+    #pragma endregion
+};
+#pragma endregion
+#endif